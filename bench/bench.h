@@ -0,0 +1,51 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace bench
+{
+    using BenchFunction = void (*)();
+
+    struct Entry
+    {
+        const char *name;
+        BenchFunction function;
+    };
+
+    std::vector<Entry> &registry();
+
+    struct Register
+    {
+        Register(const char *name, BenchFunction function)
+        {
+            registry().push_back({name, function});
+        }
+    };
+
+    /// @brief Print one measurement as "benchmark/label: value unit"
+    void report(const std::string &label, double value, const char *unit);
+
+    /// @brief Keep the compiler from optimizing away a computed value
+    template <typename T>
+    inline void do_not_optimize(const T &value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    /// @brief Wall clock seconds taken by one call of f
+    template <typename F>
+    double seconds(F &&f)
+    {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double>(end - start).count();
+    }
+}
+
+#define BENCHMARK(name)                                          \
+    static void name();                                          \
+    static bench::Register name##_register(#name, name);         \
+    static void name()
@@ -0,0 +1,110 @@
+#include "bench.h"
+#include "combinators.h"
+#include "watchdog_behavior.h"
+
+using namespace state_machine;
+
+namespace
+{
+    const std::size_t selects = 5'000'000;
+
+    class ConstantFeedback : public ILightFeedback
+    {
+    public:
+        bool light_voltage() override
+        {
+            return true;
+        }
+    };
+
+    class NeverTimer : public ITimer
+    {
+    public:
+        ITimer &reset(double) override { return *this; }
+        bool expired() const override { return false; }
+    };
+}
+
+BENCHMARK(when_any_select)
+{
+    // Baseline, the same decision written as a plain poll
+    volatile bool a = false;
+    volatile bool b = true;
+    std::size_t winners = 0;
+    auto elapsed = bench::seconds([&]
+                                  {
+        for (std::size_t i = 0; i < selects; ++i)
+        {
+            winners += a ? 0 : (b ? 1 : 2);
+        } });
+    bench::do_not_optimize(winners);
+    bench::report("plain poll", elapsed / selects * 1e9, "ns per select");
+
+    // Second operation already complete, the race never suspends
+    winners = 0;
+    auto ready = [&]() -> FrameTask
+    {
+        for (std::size_t i = 0; i < selects; ++i)
+        {
+            winners += co_await when_any(until([&]
+                                               { return a; }),
+                                         until([&]
+                                               { return b; }));
+        }
+    };
+    auto task = ready();
+    elapsed = bench::seconds([&]
+                             { task.resume(); });
+    bench::do_not_optimize(winners);
+    bench::report("when_any ready", elapsed / selects * 1e9, "ns per select");
+
+    // Each race waits one frame, measuring suspend, blocked poll and resume
+    std::size_t frame = 0;
+    auto suspending = [&]() -> FrameTask
+    {
+        for (std::size_t i = 0; i < selects; ++i)
+        {
+            auto started = frame;
+            winners += co_await when_any(until([&]
+                                               { return a; }),
+                                         until([&]
+                                               { return frame != started; }));
+        }
+    };
+    auto suspending_task = suspending();
+    elapsed = bench::seconds([&]
+                             {
+        while (!suspending_task.done())
+        {
+            frame++;
+            suspending_task.resume();
+        } });
+    bench::report("when_any one frame", elapsed / selects * 1e9, "ns per select");
+}
+
+BENCHMARK(watchdog_select)
+{
+    // The flashing race with a child monitor coroutine started and dropped every select
+    ConstantFeedback feedback;
+    NeverTimer transition_timer;
+    volatile bool released = false;
+    volatile bool expired = true;
+    std::size_t timers = 0;
+    auto racing = [&]() -> FrameTask
+    {
+        for (std::size_t i = 0; i < selects; ++i)
+        {
+            const char *failure = nullptr;
+            timers += co_await when_any(until([&]
+                                              { return released; }),
+                                        until([&]
+                                              { return expired; }),
+                                        monitor_voltage_transition(feedback, transition_timer, true, 0.1, failure));
+        }
+    };
+    auto task = racing();
+    auto elapsed = bench::seconds([&]
+                                  { task.resume(); });
+    bench::do_not_optimize(timers);
+    bench::report("when_any with monitor coroutine", elapsed / selects * 1e9, "ns per select");
+}
@@ -0,0 +1,66 @@
+#include <deque>
+#include <string>
+#include "bench.h"
+#include "fiber.h"
+#include "simulation.h"
+
+using namespace state_machine;
+
+BENCHMARK(fiber_switch)
+{
+    // Few fibers stay in cache, many show the cost of touching each stack
+    for (std::size_t fibers : {10, 1'000})
+    {
+        const std::size_t rounds = 1'000'000 / fibers;
+        FiberScheduler scheduler;
+        for (std::size_t i = 0; i < fibers; ++i)
+        {
+            scheduler.spawn([]
+                            {
+                while (true)
+                {
+                    FiberScheduler::yield();
+                } });
+        }
+        auto elapsed = bench::seconds([&]
+                                      {
+            for (std::size_t round = 0; round < rounds; ++round)
+            {
+                scheduler.round();
+            } });
+        // Each resume is a switch in and a switch out
+        bench::report(std::to_string(fibers) + " fibers yield", elapsed / (rounds * fibers * 2) * 1e9, "ns per switch");
+    }
+}
+
+BENCHMARK(fiber_blocking_start)
+{
+    const std::size_t count = 10'000;
+    const int frames = 100;
+    VirtualClock clock;
+    FiberScheduler scheduler(16 * 1024);
+    std::deque<SimIO> sim_io;
+    std::deque<SimTimer> sim_timers;
+    std::deque<FiberIO> io;
+    std::deque<FiberTimer> timers;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        auto &fiber_io = io.emplace_back(scheduler, sim_io.emplace_back(clock));
+        auto &fiber_timer = timers.emplace_back(scheduler, sim_timers.emplace_back(clock));
+        scheduler.spawn([&]
+                        { start(fiber_io, fiber_timer); });
+    }
+    auto elapsed = bench::seconds([&]
+                                  {
+        for (int frame = 0; frame < frames; ++frame)
+        {
+            clock.advance_to(frame * 0.1);
+            for (auto &sim : sim_io)
+            {
+                sim.button_pressed_value = (frame / 30) % 2 == 1;
+            }
+            scheduler.round();
+        } });
+    bench::report("unmodified start()", elapsed / (frames * count) * 1e9, "ns per behavior per frame");
+    bench::report("stack memory", static_cast<double>(scheduler.stacks().mapped() * scheduler.stacks().stack_size()) / (1 << 20), "MB reserved");
+}
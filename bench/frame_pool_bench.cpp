@@ -0,0 +1,65 @@
+#include <vector>
+#include "bench.h"
+#include "frame_pool.h"
+
+using namespace state_machine;
+
+BENCHMARK(frame_pool)
+{
+    const std::size_t behaviors = 10'000;
+    const std::size_t frames = 1'000;
+    std::size_t work = 0;
+
+    // Every behavior waits one frame at a time, resumed by walking the parked list
+    FramePool pool;
+    auto yielding = [&]() -> FrameTask
+    {
+        for (;;)
+        {
+            co_await pool.next_frame();
+            work++;
+        }
+    };
+    std::vector<FrameTask> tasks;
+    tasks.reserve(behaviors);
+    for (std::size_t i = 0; i < behaviors; ++i)
+    {
+        tasks.push_back(yielding());
+        tasks.back().resume();
+    }
+    auto elapsed = bench::seconds([&]
+                                  {
+        for (std::size_t frame = 0; frame < frames; ++frame)
+        {
+            pool.frame();
+        } });
+    bench::do_not_optimize(work);
+    bench::report("pool frame", elapsed / frames / behaviors * 1e9, "ns per behavior");
+
+    // Baseline, the owner resumes every task with std::suspend_always between frames
+    auto suspending = [&]() -> FrameTask
+    {
+        for (;;)
+        {
+            co_await std::suspend_always{};
+            work++;
+        }
+    };
+    std::vector<FrameTask> polled;
+    polled.reserve(behaviors);
+    for (std::size_t i = 0; i < behaviors; ++i)
+    {
+        polled.push_back(suspending());
+    }
+    elapsed = bench::seconds([&]
+                             {
+        for (std::size_t frame = 0; frame < frames; ++frame)
+        {
+            for (auto &task : polled)
+            {
+                task.resume();
+            }
+        } });
+    bench::do_not_optimize(work);
+    bench::report("owner resume", elapsed / frames / behaviors * 1e9, "ns per behavior");
+}
@@ -0,0 +1,363 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <optional>
+#include <random>
+#include <string>
+#include <utility>
+#include <unistd.h>
+#include "beam_graph.h"
+#include "bench.h"
+#include "bitboard_grid.h"
+#include "edge_search.h"
+#include "grid_registry.h"
+#include "grid_snapshot.h"
+#include "lib.h"
+#include "mapped_grid.h"
+#include "multi_trace.h"
+#include "reverse_index.h"
+#include "sparse_grid.h"
+#include "trace_timeline.h"
+
+BENCHMARK(sparse_trace)
+{
+    const int size = 1000;
+    for (double density : {0.001, 0.01})
+    {
+        auto grid = lib::random_grid(size, size, density, 42);
+        cells::SparseGrid sparse(grid);
+        auto label = "grid/" + std::to_string(size) + " density " + std::to_string(density);
+
+        const int entries = 8;
+        std::size_t energized = 0;
+        auto dense = bench::seconds([&]
+                                    {
+            for (int y = 0; y < entries; ++y)
+            {
+                energized += cells::trace_grid(grid, {0, y * size / entries}, cells::Direction::Right);
+            } });
+        auto compressed = bench::seconds([&]
+                                         {
+            for (int y = 0; y < entries; ++y)
+            {
+                energized -= cells::trace_grid(sparse, {0, y * size / entries}, cells::Direction::Right);
+            } });
+        bench::do_not_optimize(energized);
+        bench::report(label + " dense trace", dense / entries * 1e3, "ms");
+        bench::report(label + " sparse trace", compressed / entries * 1e3, "ms");
+        bench::report(label + " sparse obstacles", static_cast<double>(sparse.obstacle_count()), "cells");
+    }
+}
+
+// HUGE_GRID_SIZE=100000 gives the 100k x 100k (10GB) case, the default keeps a normal run short
+BENCHMARK(huge_grid)
+{
+    const char *size_env = std::getenv("HUGE_GRID_SIZE");
+    const cells::Coord size = size_env ? std::atoll(size_env) : 10'000;
+    const double density = 0.0005;
+    const auto path = (std::filesystem::temp_directory_path() / "huge_grid_bench.grid").string();
+    auto label = "grid/" + std::to_string(size);
+
+    auto write = bench::seconds([&]
+                                { cells::write_tile_file(path, size, size, 256, [&](std::uint64_t tile_x, std::uint64_t tile_y, std::span<cells::Cell> cells)
+                                                         {
+            std::mt19937 generator(static_cast<unsigned>(tile_y * 1'000'003 + tile_x));
+            std::uniform_int_distribution<std::size_t> position(0, cells.size() - 1);
+            std::uniform_int_distribution<int> kind(1, 4);
+            std::binomial_distribution<std::size_t> count(cells.size(), density);
+            for (auto n = count(generator); n > 0; --n)
+            {
+                cells[position(generator)] = static_cast<cells::Cell>(kind(generator));
+            } }); });
+    {
+        cells::MappedGrid grid(path);
+        std::size_t energized = 0;
+        auto trace = bench::seconds([&]
+                                    { energized = cells::trace_grid(grid, {0, size / 2}, cells::Direction::Right); });
+        bench::do_not_optimize(energized);
+        bench::report(label + " write", write, "s");
+        bench::report(label + " file", static_cast<double>(std::filesystem::file_size(path)) / (1 << 20), "MB");
+        bench::report(label + " trace", trace, "s");
+        bench::report(label + " energized", static_cast<double>(energized), "cells");
+    }
+    std::filesystem::remove(path);
+}
+
+BENCHMARK(edge_sweep)
+{
+    // Problem sized grid, every edge entry traced
+    const int size = 110;
+    auto grid = lib::random_grid(size, size, 0.1, 7);
+    auto entries = cells::edge_entries(size, size);
+    std::size_t best = 0;
+    auto single = bench::seconds([&]
+                                 {
+        for (const auto &entry : entries)
+        {
+            best = std::max(best, cells::trace_grid(grid, entry.location, entry.direction));
+        } });
+    bench::do_not_optimize(best);
+    bench::report("grid/110 trace_grid per entry", single * 1e3, "ms");
+    for (std::size_t lanes : {64, 256})
+    {
+        std::vector<std::size_t> results;
+        auto multi = bench::seconds([&]
+                                    { results = cells::trace_entries(grid, entries, lanes); });
+        bench::do_not_optimize(results);
+        bench::report("grid/110 trace_entries " + std::to_string(lanes) + " lanes", multi * 1e3, "ms");
+    }
+
+    // Grouping by first obstacle pays off most on sparse grids
+    for (double density : {0.1, 0.01})
+    {
+        auto sparse = lib::random_grid(size, size, density, 7);
+        cells::EdgeSweep sweep;
+        auto shared = bench::seconds([&]
+                                     { sweep = cells::sweep_edges(sparse); });
+        auto label = "grid/110 density " + std::to_string(density);
+        bench::report(label + " sweep_edges", shared * 1e3, "ms");
+        bench::report(label + " full traces", static_cast<double>(sweep.full_traces) / static_cast<double>(sweep.entries.size()) * 100, "% of entries");
+    }
+}
+
+BENCHMARK(bitboard_trace)
+{
+    for (auto [size, density] : {std::pair{110, 0.1}, std::pair{110, 0.5}, std::pair{400, 0.5}})
+    {
+        auto grid = lib::random_grid(size, size, density, 11);
+        cells::BitboardGrid bitboard(grid);
+        auto label = "grid/" + std::to_string(size) + " density " + std::to_string(density);
+
+        const int entries = 8;
+        std::size_t energized = 0;
+        auto stack = bench::seconds([&]
+                                    {
+            for (int y = 0; y < entries; ++y)
+            {
+                energized += cells::trace_grid(grid, {0, y * size / entries}, cells::Direction::Right);
+            } });
+        auto word_parallel = bench::seconds([&]
+                                            {
+            for (int y = 0; y < entries; ++y)
+            {
+                energized -= cells::trace_grid(bitboard, {0, y * size / entries}, cells::Direction::Right);
+            } });
+        bench::do_not_optimize(energized);
+        bench::report(label + " stack trace", stack / entries * 1e3, "ms");
+        bench::report(label + " bitboard trace", word_parallel / entries * 1e3, "ms");
+    }
+}
+
+BENCHMARK(beam_graph)
+{
+    for (auto [size, density] : {std::pair{110, 0.1}, std::pair{400, 0.05}})
+    {
+        auto grid = lib::random_grid(size, size, density, 7);
+        auto entries = cells::edge_entries(size, size);
+        auto label = "grid/" + std::to_string(size) + " density " + std::to_string(density);
+
+        std::vector<std::size_t> multi;
+        auto passes = bench::seconds([&]
+                                     { multi = cells::trace_entries(grid, entries); });
+        std::optional<cells::BeamGraph> graph;
+        auto build = bench::seconds([&]
+                                    { graph.emplace(grid); });
+        std::size_t best = 0;
+        auto queries = bench::seconds([&]
+                                      {
+            for (const auto &entry : entries)
+            {
+                best = std::max(best, graph->trace(entry.location, entry.direction));
+            } });
+        cells::TopEdges top;
+        auto pruned = bench::seconds([&]
+                                     { top = cells::top_edges(*graph, 1); });
+        bench::do_not_optimize(best);
+        bench::report(label + " trace_entries sweep", passes * 1e3, "ms");
+        bench::report(label + " graph build", build * 1e3, "ms");
+        bench::report(label + " graph sweep", queries * 1e3, "ms");
+        bench::report(label + " graph top 1", pruned * 1e3, "ms");
+        bench::report(label + " top 1 exact traces", static_cast<double>(top.exact_traces), "entries");
+        bench::report(label + " segments", static_cast<double>(graph->node_count()), "nodes");
+        bench::report(label + " components", static_cast<double>(graph->component_count()), "nodes");
+        bench::report(label + " graph memory", static_cast<double>(graph->memory_bytes()) / (1 << 20), "MB");
+    }
+}
+
+BENCHMARK(reverse_index)
+{
+    for (auto [size, density] : {std::pair{110, 0.1}, std::pair{400, 0.05}})
+    {
+        auto grid = lib::random_grid(size, size, density, 7);
+        auto label = "grid/" + std::to_string(size) + " density " + std::to_string(density);
+
+        std::optional<cells::ReverseBeamIndex> index;
+        auto build = bench::seconds([&]
+                                    { index.emplace(grid); });
+        const int queries = 64;
+        std::size_t reaching = 0;
+        auto lookups = bench::seconds([&]
+                                      {
+            for (int i = 0; i < queries; ++i)
+            {
+                reaching += index->entries_reaching(i * 7 % size, i * 13 % size).count();
+            } });
+        bench::do_not_optimize(reaching);
+        bench::report(label + " index build", build * 1e3, "ms");
+        bench::report(label + " cell query", lookups / queries * 1e3, "ms");
+        bench::report(label + " entries per cell", static_cast<double>(reaching) / queries, "entries");
+    }
+}
+
+BENCHMARK(multi_source_trace)
+{
+    const int size = 110;
+    auto grid = lib::random_grid(size, size, 0.1, 5);
+    std::vector<cells::Beam> sources;
+    for (int y = 0; y < size; y += 4)
+    {
+        sources.emplace_back(cells::XY{0, y}, cells::Direction::Right);
+    }
+
+    std::size_t energized = 0;
+    auto repeated = bench::seconds([&]
+                                   {
+        for (const auto &source : sources)
+        {
+            energized += cells::trace_grid(grid, source.location, source.direction);
+        } });
+    auto single_pass = bench::seconds([&]
+                                      { energized += cells::trace_grid(grid, sources); });
+    // Threshold well under a typical trace, so each query stops early
+    bool any = false;
+    auto threshold = bench::seconds([&]
+                                    {
+        for (const auto &source : sources)
+        {
+            any |= cells::trace_exceeds(grid, source.location, source.direction, 100);
+        } });
+    bench::do_not_optimize(energized);
+    bench::do_not_optimize(any);
+    auto label = std::to_string(sources.size()) + " sources";
+    bench::report(label + " traced one by one", repeated * 1e3, "ms");
+    bench::report(label + " single pass", single_pass * 1e3, "ms");
+    bench::report(label + " trace_exceeds 100 one by one", threshold * 1e3, "ms");
+}
+
+BENCHMARK(trace_limits)
+{
+    const int size = 400;
+    auto grid = lib::random_grid(size, size, 0.1, 1);
+    const cells::XY entry{0, 2};
+
+    std::size_t energized = 0;
+    auto plain = bench::seconds([&]
+                                { energized += cells::trace_grid(grid, entry, cells::Direction::Right); });
+    cells::CancellationToken token;
+    cells::TraceLimits limits;
+    limits.cancel = &token;
+    limits.deadline = std::chrono::steady_clock::now() + std::chrono::hours(1);
+    std::size_t reports = 0;
+    limits.progress = [&](std::size_t, std::size_t)
+    { reports++; };
+    cells::TraceResult result;
+    auto limited = bench::seconds([&]
+                                  { result = cells::trace_grid(grid, entry, cells::Direction::Right, limits); });
+    bench::do_not_optimize(energized);
+    bench::report("trace_grid", plain * 1e3, "ms");
+    bench::report("trace_grid with token, deadline and progress", limited * 1e3, "ms");
+    bench::report("beam steps", static_cast<double>(result.steps), "steps");
+    bench::report("progress reports", static_cast<double>(reports), "calls");
+}
+
+BENCHMARK(shared_grid)
+{
+    const int size = 2000;
+    auto grid = lib::random_grid(size, size, 0.01, 3);
+    cells::GridRegistry registry("cells_bench_" + std::to_string(::getpid()));
+
+    auto publish = bench::seconds([&]
+                                  { registry.publish("grid", grid); });
+    std::optional<cells::SharedGrid> shared;
+    auto open = bench::seconds([&]
+                               { shared.emplace(registry.open("grid")); });
+    std::size_t energized = 0;
+    auto dense = bench::seconds([&]
+                                { energized += cells::trace_grid(grid, {0, 0}, cells::Direction::Right); });
+    auto mapped = bench::seconds([&]
+                                 { energized -= cells::trace_grid(shared->grid(), {0, 0}, cells::Direction::Right); });
+    bench::do_not_optimize(energized);
+    shared.reset();
+    registry.remove("grid");
+    bench::report("grid/2000 publish", publish * 1e3, "ms");
+    bench::report("grid/2000 open in a reader", open * 1e3, "ms");
+    bench::report("grid/2000 trace in-process Grid", dense * 1e3, "ms");
+    bench::report("grid/2000 trace shared grid", mapped * 1e3, "ms");
+}
+
+BENCHMARK(grid_snapshot)
+{
+    const int size = 2000;
+    auto grid = lib::random_grid(size, size, 0.01, 3);
+    cells::GridEditor editor(grid);
+    // Same cells as grid, for comparing trace speed
+    auto original = editor.current();
+
+    const int edits = 100;
+    std::size_t copied = 0;
+    auto publish = bench::seconds([&]
+                                  {
+        for (int i = 0; i < edits; ++i)
+        {
+            editor.set(i * 17 % size, i * 31 % size, cells::Cell::Slash);
+            copied += editor.copied_tiles();
+            editor.publish();
+        } });
+    std::optional<cells::Grid> copy;
+    auto deep_copy = bench::seconds([&]
+                                    { copy.emplace(grid); });
+    std::size_t energized = 0;
+    auto dense = bench::seconds([&]
+                                { energized += cells::trace_grid(grid, {0, 0}, cells::Direction::Right); });
+    auto tiled = bench::seconds([&]
+                                { energized -= cells::trace_grid(*original, {0, 0}, cells::Direction::Right); });
+    bench::do_not_optimize(energized);
+    bench::do_not_optimize(copied);
+    bench::report("grid/2000 one edit and publish", publish / edits * 1e3, "ms");
+    bench::report("grid/2000 deep copy of Grid", deep_copy * 1e3, "ms");
+    bench::report("grid/2000 trace Grid", dense * 1e3, "ms");
+    bench::report("grid/2000 trace snapshot", tiled * 1e3, "ms");
+}
+
+BENCHMARK(trace_timeline)
+{
+    const int size = 2000;
+    auto grid = lib::random_grid(size, size, 0.01, 3);
+    std::size_t energized = 0;
+    auto plain = bench::seconds([&]
+                                { energized += cells::trace_grid(grid, {0, 0}, cells::Direction::Right); });
+    cells::TraceTimeline timeline;
+    auto timed = bench::seconds([&]
+                                { timeline = cells::trace_timeline(grid, {0, 0}, cells::Direction::Right); });
+    bench::do_not_optimize(energized);
+    bench::report("grid/2000 trace_grid", plain * 1e3, "ms");
+    bench::report("grid/2000 trace_timeline", timed * 1e3, "ms");
+    bench::report("grid/2000 timeline steps", static_cast<double>(timeline.new_cells.size()), "steps");
+}
+
+BENCHMARK(parse_grid)
+{
+    const int size = 8000;
+    auto grid = lib::random_grid(size, size, 0.05, 8);
+    auto text = lib::grid_to_lines(grid);
+    const double megabytes = static_cast<double>(text.size()) / (1 << 20);
+    for (unsigned threads : {1u, 2u, 4u, 0u})
+    {
+        std::optional<cells::Grid> parsed;
+        auto seconds = bench::seconds([&]
+                                      { parsed.emplace(lib::lines_to_grid(text, threads)); });
+        auto label = threads == 0 ? std::string("all cores") : std::to_string(threads) + " threads";
+        bench::report("parse 64MB grid, " + label, megabytes / seconds, "MB/s");
+    }
+}
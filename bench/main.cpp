@@ -0,0 +1,36 @@
+#include <cstring>
+#include <iostream>
+#include "bench.h"
+
+namespace bench
+{
+    std::vector<Entry> &registry()
+    {
+        static std::vector<Entry> entries;
+        return entries;
+    }
+
+    void report(const std::string &label, double value, const char *unit)
+    {
+        std::cout << label << ": " << value << " " << unit << "\n";
+    }
+}
+
+// Usage: benchmarks [substring]   runs every benchmark whose name contains substring
+int main(int argc, char **argv)
+{
+#ifndef NDEBUG
+    std::cout << "warning: benchmarks built without optimization\n";
+#endif
+    const char *filter = argc > 1 ? argv[1] : "";
+    for (const auto &entry : bench::registry())
+    {
+        if (std::strstr(entry.name, filter) == nullptr)
+        {
+            continue;
+        }
+        std::cout << "== " << entry.name << "\n";
+        entry.function();
+    }
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include <string>
+#include <vector>
+#include "bench.h"
+#include "model.h"
+#include "model_batch.h"
+
+namespace
+{
+    const std::size_t checks = 1'000'000;
+
+    template <std::size_t Fields>
+    void validity(const std::string &name)
+    {
+        auto model = clarity::BasicModel<Fields>();
+        model.turnPowerOn();
+        model.setStates(1);
+        model.setOtherValues(1);
+
+        // Every check follows a single field update, the config editing pattern
+        std::size_t valid = 0;
+        auto rescan = bench::seconds([&]
+                                     {
+            for (std::size_t i = 0; i < checks; ++i)
+            {
+                model.setOtherValue(i % Fields, static_cast<int>(i & 1) + 1);
+                valid += model.isValidOld4();
+            } });
+        auto incremental = bench::seconds([&]
+                                          {
+            for (std::size_t i = 0; i < checks; ++i)
+            {
+                model.setOtherValue(i % Fields, static_cast<int>(i & 1) + 1);
+                valid += model.isValid();
+            } });
+        bench::do_not_optimize(valid);
+        bench::report(name + " rescan", rescan / checks * 1e9, "ns per update+check");
+        bench::report(name + " incremental", incremental / checks * 1e9, "ns per update+check");
+    }
+}
+
+BENCHMARK(model_validity)
+{
+    validity<16>("model/16");
+    validity<1024>("model/1024");
+    validity<4096>("model/4096");
+}
+
+BENCHMARK(model_batch_validity)
+{
+    const std::size_t count = 100'000;
+    std::vector<clarity::Model> models(count);
+    clarity::ModelBatch batch;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        auto index = batch.add();
+        models[i].turnPowerOn();
+        batch.turnPowerOn(index);
+        models[i].setStates(1);
+        batch.setStates(index, 1);
+        models[i].setOtherValues(1);
+        batch.setOtherValues(index, 1);
+    }
+
+    const int rounds = 20;
+    std::size_t valid = 0;
+    auto rescan = bench::seconds([&]
+                                 {
+        for (int round = 0; round < rounds; ++round)
+        {
+            for (auto &model : models)
+            {
+                valid += model.isValidOld4();
+            }
+        } });
+    auto batched = bench::seconds([&]
+                                  {
+        for (int round = 0; round < rounds; ++round)
+        {
+            auto bitmap = batch.validate();
+            valid += bitmap[0] & 1;
+        } });
+    bench::do_not_optimize(valid);
+    bench::report("models/100000 rescan each", rescan / (rounds * count) * 1e9, "ns per model");
+    bench::report("models/100000 batch bitmap", batched / (rounds * count) * 1e9, "ns per model");
+}
@@ -0,0 +1,195 @@
+#include <deque>
+#include <string>
+#include "bench.h"
+#include "batch_behavior.h"
+#include "coroutine_behavior.h"
+#include "executive.h"
+#include "simulation.h"
+#include "table_behavior.h"
+
+using namespace state_machine;
+
+namespace
+{
+    // IO without a trace, so benchmarks measure the behavior and not the recording
+    class BenchIO : public IIO
+    {
+    public:
+        void set_light(OnOff on_or_off) override
+        {
+            light_value = on_or_off;
+            writes++;
+        }
+        bool button_pressed() override
+        {
+            return button_pressed_value;
+        }
+        bool button_released() override
+        {
+            return !button_pressed_value;
+        }
+        OnOff light_value = OnOff::Off;
+        bool button_pressed_value = false;
+        std::size_t writes = 0;
+    };
+
+    const std::size_t frame_budget = 2'000'000;
+    const std::size_t instance_counts[] = {1, 100, 10'000};
+
+    /// Frame engines share the (IIO &, ITimer &) interface.  Each frame advances the
+    /// clock by a full blink period, so every pressed instance toggles once per frame.
+    template <typename Behavior>
+    void frame_engine(const std::string &name, std::size_t instance_bytes)
+    {
+        struct Instance
+        {
+            Instance(const VirtualClock &clock) : timer(clock), behavior(io, timer) {}
+            BenchIO io;
+            SimTimer timer;
+            Behavior behavior;
+        };
+
+        for (auto count : instance_counts)
+        {
+            for (bool pressed : {true, false})
+            {
+                VirtualClock clock;
+                std::deque<Instance> instances;
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    instances.emplace_back(clock).io.button_pressed_value = pressed;
+                }
+                const auto frames = frame_budget / count;
+                double now = 0.0;
+                auto elapsed = bench::seconds([&]
+                                              {
+                    for (std::size_t frame = 0; frame < frames; ++frame)
+                    {
+                        clock.advance_to(now += 1.0);
+                        for (auto &instance : instances)
+                        {
+                            instance.behavior.do_work();
+                        }
+                    } });
+
+                auto label = name + "/" + std::to_string(count) + (pressed ? "/active" : "/idle");
+                bench::report(label + " frame latency", elapsed / frames * 1e9, "ns");
+                if (pressed)
+                {
+                    bench::report(label + " transitions", frames * count / elapsed, "per second");
+                }
+            }
+        }
+        bench::report(name + " memory per instance", static_cast<double>(instance_bytes), "bytes");
+    }
+}
+
+BENCHMARK(switch_behavior)
+{
+    frame_engine<PolledButtonBehavior>("switch", sizeof(PolledButtonBehavior));
+}
+
+BENCHMARK(table_behavior)
+{
+    frame_engine<TableButtonBehavior>("table", sizeof(TableButtonBehavior));
+}
+
+BENCHMARK(coroutine_behavior)
+{
+    frame_engine<CoroutineButtonBehavior>("coroutine", sizeof(CoroutineButtonBehavior) + CoroutineButtonBehavior::frame_size());
+}
+
+BENCHMARK(batch_behavior)
+{
+    for (auto count : instance_counts)
+    {
+        for (bool pressed : {true, false})
+        {
+            ButtonBehaviorBatch batch;
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                batch.set_button(batch.add(), pressed);
+            }
+            const auto frames = frame_budget / count;
+            std::size_t transitions = 0;
+            double now = 0.0;
+            auto elapsed = bench::seconds([&]
+                                          {
+                for (std::size_t frame = 0; frame < frames; ++frame)
+                {
+                    transitions += batch.step(now += 1.0);
+                } });
+            bench::do_not_optimize(transitions);
+
+            auto label = "batch/" + std::to_string(count) + (pressed ? "/active" : "/idle");
+            bench::report(label + " frame latency", elapsed / frames * 1e9, "ns");
+            if (pressed)
+            {
+                bench::report(label + " transitions", transitions / elapsed, "per second");
+            }
+        }
+    }
+    bench::report("batch memory per instance", ButtonBehaviorBatch::bytes_per_instance, "bytes");
+}
+
+BENCHMARK(executive_behavior)
+{
+    // Same workload as the frame engines, but idle instances are never run
+    for (auto count : instance_counts)
+    {
+        for (bool pressed : {true, false})
+        {
+            Executive executive;
+            std::deque<ScheduledButtonBehavior> behaviors;
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                auto &behavior = behaviors.emplace_back(executive);
+                behavior.io.set_button(pressed);
+                executive.add(behavior);
+            }
+            executive.frame(0.0);
+
+            const auto frames = frame_budget / count;
+            const auto runs = executive.runs();
+            double now = 0.0;
+            auto elapsed = bench::seconds([&]
+                                          {
+                for (std::size_t frame = 0; frame < frames; ++frame)
+                {
+                    executive.frame(now += 1.0);
+                } });
+
+            auto label = "executive/" + std::to_string(count) + (pressed ? "/active" : "/idle");
+            bench::report(label + " frame latency", elapsed / frames * 1e9, "ns");
+            bench::report(label + " runs", static_cast<double>(executive.runs() - runs) / frames, "per frame");
+        }
+    }
+}
+
+BENCHMARK(blocking_behavior)
+{
+    // The blocking style owns its thread, so only throughput is meaningful.  The
+    // timer is always expired and the button releases after a fixed number of toggles.
+    class ReleasingIO : public BenchIO
+    {
+    public:
+        bool button_released() override
+        {
+            return writes > toggles;
+        }
+        std::size_t toggles = frame_budget;
+    };
+    class ExpiredTimer : public ITimer
+    {
+    public:
+        ITimer &reset(double) override { return *this; }
+        bool expired() const override { return true; }
+    };
+
+    ReleasingIO io;
+    io.button_pressed_value = true;
+    ExpiredTimer timer;
+    auto elapsed = bench::seconds([&]
+                                  { flash_until_button_released(io, timer); });
+    bench::report("blocking/1 transitions", io.toggles / elapsed, "per second");
+}
@@ -0,0 +1,59 @@
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include "bench.h"
+#include "lib.h"
+#include "trace_daemon.h"
+
+BENCHMARK(trace_daemon)
+{
+    auto path = "/tmp/trace_daemon_bench." + std::to_string(::getpid()) + ".sock";
+    cells::TraceServer server(path);
+    std::thread serving([&]
+                        { server.run(); });
+
+    const int size = 110;
+    auto grid = lib::random_grid(size, size, 0.1, 7);
+    auto text = lib::grid_to_lines(grid);
+    auto entries = cells::edge_entries(size, size);
+
+    {
+        cells::TraceClient client(path);
+        std::uint32_t handle = 0;
+        auto load = bench::seconds([&]
+                                   { handle = client.load(text); });
+        std::uint64_t total = 0;
+        auto one_by_one = bench::seconds([&]
+                                         {
+            for (const auto &entry : entries)
+            {
+                total += client.trace(handle, std::span(&entry, 1))[0];
+            } });
+        auto pipelined = bench::seconds([&]
+                                        {
+            std::vector<std::uint32_t> tags;
+            for (const auto &entry : entries)
+            {
+                tags.push_back(client.send_trace(handle, std::span(&entry, 1)));
+            }
+            for (auto tag : tags)
+            {
+                total += client.receive_trace(tag)[0];
+            } });
+        auto batched = bench::seconds([&]
+                                      {
+            for (auto count : client.trace(handle, entries))
+            {
+                total += count;
+            } });
+        bench::do_not_optimize(total);
+        const auto queries = static_cast<double>(entries.size());
+        bench::report("load and index 110x110", load * 1e3, "ms");
+        bench::report("round trip per query", one_by_one / queries * 1e6, "us");
+        bench::report("pipelined per query", pipelined / queries * 1e6, "us");
+        bench::report("batched per query", batched / queries * 1e6, "us");
+    }
+
+    server.stop();
+    serving.join();
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "state_machine.h"
+
+namespace state_machine
+{
+    /// @brief Struct-of-arrays engine running many blinking light behaviors at once.
+    /// Inputs, outputs, states and timer deadlines are kept in parallel arrays
+    /// and every instance is stepped in one pass, with no virtual IO calls.
+    class ButtonBehaviorBatch
+    {
+    public:
+        using States = PolledButtonBehavior::States;
+
+        /// @brief Add a new instance, not pressed with the light off
+        std::size_t add();
+        std::size_t size() const
+        {
+            return states_.size();
+        }
+
+        void set_button(std::size_t index, bool pressed)
+        {
+            buttons_[index] = pressed;
+        }
+        OnOff light(std::size_t index) const
+        {
+            return lights_[index] ? OnOff::On : OnOff::Off;
+        }
+        States state(std::size_t index) const
+        {
+            return static_cast<States>(states_[index]);
+        }
+
+        /// @brief Run every instance to quiescence at time now
+        /// @return number of state transitions made
+        std::size_t step(double now);
+
+        /// @brief Bytes of storage used by a single instance
+        static constexpr std::size_t bytes_per_instance = 3 * sizeof(std::uint8_t) + sizeof(double);
+
+    private:
+        std::vector<std::uint8_t> states_;
+        std::vector<std::uint8_t> buttons_;
+        std::vector<std::uint8_t> lights_;
+        std::vector<double> deadlines_;
+    };
+}
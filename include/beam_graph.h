@@ -0,0 +1,98 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "cells.h"
+
+namespace cells
+{
+    /// @brief Precomputed answers for trace_grid from any entry of a Grid.
+    ///
+    /// Nodes are the straight beam segments leaving each non-space cell in each
+    /// direction it can send light, up to and including the next non-space cell.
+    /// A segment leads to the segments leaving the cell it ends on.  Strongly
+    /// connected components of that graph energize the same cells, so they are
+    /// condensed into a DAG that keeps, per component, its own cells and the
+    /// components it leads to.
+    ///
+    /// The cells energized from a component are only stored for the
+    /// components edge entries lead to, each as a sorted cell list or a bitset,
+    /// whichever is smaller.  A query walks to the first non-space cell and
+    /// unions those sets with the straight prefix; a query from inside the
+    /// grid walks the DAG instead.
+    class BeamGraph
+    {
+    public:
+        /// Bytes a graph may use unless the constructor is told otherwise
+        static constexpr std::size_t default_memory_budget = std::size_t(1) << 30;
+
+        /// @brief Throws, before allocating, when building the graph would take
+        /// more than memory_budget bytes or the grid has more segments than
+        /// 32 bit node ids can number
+        explicit BeamGraph(const Grid &grid, std::size_t memory_budget = default_memory_budget);
+
+        Coord width() const
+        {
+            return width_;
+        }
+        Coord height() const
+        {
+            return height_;
+        }
+        std::size_t node_count() const
+        {
+            return node_component_.size();
+        }
+        std::size_t component_count() const
+        {
+            return own_offsets_.size() - 1;
+        }
+        /// @brief Bytes held by the graph once built
+        std::size_t memory_bytes() const;
+
+        /// @brief Same result as trace_grid on the source Grid
+        std::size_t trace(const XY &entry_location, const Direction &entry_direction) const;
+        /// @brief Cheap bound on trace: the straight prefix plus the sizes of
+        /// the stored sets it leads to, without forming their union.  Exact,
+        /// and no cheaper than trace, when the entry leads to components no
+        /// edge entry does.
+        std::size_t upper_bound(const XY &entry_location, const Direction &entry_direction) const;
+
+    private:
+        static constexpr std::uint32_t no_node = UINT32_MAX;
+
+        /// Cells energized from a component, in cells or in bits
+        struct Reach
+        {
+            std::size_t size = 0;
+            std::vector<std::uint32_t> cells;
+            std::vector<std::uint64_t> bits;
+        };
+
+        std::size_t cell_index(Coord x, Coord y) const
+        {
+            return static_cast<std::size_t>(y * width_ + x);
+        }
+        /// Sets the cells energized from component in energized, returns how many were new
+        std::size_t energize(std::uint32_t component, std::vector<std::uint64_t> &energized) const;
+
+        Coord width_;
+        Coord height_;
+        std::size_t words_;
+        std::vector<Cell> cells_;
+        // Node leaving cell c in direction d is node_of_[c * 4 + d], or no_node
+        std::vector<std::uint32_t> node_of_;
+        std::vector<std::uint32_t> node_component_;
+        // Cells of a component's own segments, own_cells_[own_offsets_[c]..own_offsets_[c + 1]]
+        std::vector<std::size_t> own_offsets_;
+        std::vector<std::uint32_t> own_cells_;
+        // Components a component leads to, laid out the same way
+        std::vector<std::size_t> successor_offsets_;
+        std::vector<std::uint32_t> successors_;
+        // Index into reaches_ for the components edge entries lead to, else no_node
+        std::vector<std::uint32_t> reach_of_;
+        std::vector<Reach> reaches_;
+    };
+
+    std::size_t trace_grid(const BeamGraph &graph, const XY &entry_location, const Direction &entry_direction);
+}
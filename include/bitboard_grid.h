@@ -0,0 +1,66 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "cells.h"
+
+namespace cells
+{
+    /// @brief Grid stored as bitboards, one bit per cell in 64 bit words per row.
+    ///
+    /// For every (entry direction, exit direction) pair there is a bitboard of
+    /// the cells that send a beam entering one way out the other way, so moving
+    /// every beam one step is a handful of ANDs, ORs and shifts over whole words.
+    class BitboardGrid
+    {
+    public:
+        using Plane = std::vector<std::uint64_t>;
+
+        explicit BitboardGrid(const Grid &grid);
+
+        Coord width() const
+        {
+            return width_;
+        }
+        Coord height() const
+        {
+            return height_;
+        }
+        std::size_t words_per_row() const
+        {
+            return words_per_row_;
+        }
+        /// @brief Cells that turn a beam entering in `entry` into one leaving in `exit`
+        const Plane &route(Direction entry, Direction exit) const
+        {
+            return routes_[static_cast<std::size_t>(entry)][static_cast<std::size_t>(exit)];
+        }
+
+        /// @brief (entry, exit) pairs whose route has any cell, the only ones worth computing
+        struct RoutePair
+        {
+            Direction entry;
+            Direction exit;
+        };
+        const std::vector<RoutePair> &route_pairs() const
+        {
+            return route_pairs_;
+        }
+
+    private:
+        Coord width_;
+        Coord height_;
+        std::size_t words_per_row_;
+        std::array<std::array<Plane, 4>, 4> routes_;
+        std::vector<RoutePair> route_pairs_;
+    };
+
+    /// @brief Same result as trace_grid on the source Grid, computed as a
+    /// cellular automaton: four bitboards hold the beam front per direction and
+    /// every iteration advances all of them at once, stopping when no new
+    /// (cell, direction) bits appear.  Cost is per iteration over the whole
+    /// grid, so it pays off when many beams are alive at once, as on splitter
+    /// heavy grids.
+    std::size_t trace_grid(const BitboardGrid &grid, const XY &entry_location, const Direction &entry_direction);
+}
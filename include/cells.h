@@ -1,16 +1,26 @@
 #pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <vector>
 #include <optional>
 #include <tuple>
+#include <utility>
 #include <ranges>
 #include <set>
 #include <iostream>
 #include <memory>
+#include <cstdint>
+#include <span>
+#include <type_traits>
 
 namespace cells
 {
-    // define XY as a tuple of two ints
-    using XY = std::tuple<int, int>;
+    /// @brief Grid coordinate, 64 bit so index math on huge grids cannot overflow
+    using Coord = std::int64_t;
+    // define XY as a tuple of two coordinates
+    using XY = std::tuple<Coord, Coord>;
 
     enum class Direction
     {
@@ -36,6 +46,14 @@ namespace cells
     /// @return vector of directions
     std::vector<Direction> next_directions(const Cell &self, const Direction &entry);
 
+    /// @brief next_directions without allocating, at most two directions per (cell, entry)
+    struct Exits
+    {
+        std::array<Direction, 2> directions;
+        std::size_t count;
+    };
+    const Exits &exits(const Cell &self, const Direction &entry);
+
     class Beam
     {
     public:
@@ -48,8 +66,8 @@ namespace cells
     class Grid
     {
     public:
-        Grid(std::vector<std::vector<Cell>> cells) : cells_(cells) {}
-        inline std::optional<Cell> at(int x, int y) const
+        Grid(std::vector<std::vector<Cell>> cells) : cells_(std::move(cells)) {}
+        inline std::optional<Cell> at(Coord x, Coord y) const
         {
             if (x < 0 || y < 0 || x >= width() || y >= height())
             {
@@ -57,23 +75,105 @@ namespace cells
             }
             return cells_[y][x];
         }
-        inline int width() const
+        /// @brief Cell at a location known to be on the grid
+        inline Cell cell(Coord x, Coord y) const
+        {
+            return cells_[y][x];
+        }
+        inline Coord width() const
         {
             if (cells_.size() == 0)
             {
                 return 0;
             }
-            return static_cast<int>(cells_[0].size());
+            return static_cast<Coord>(cells_[0].size());
         }
-        inline int height() const
+        inline Coord height() const
         {
-            return static_cast<int>(cells_.size());
+            return static_cast<Coord>(cells_.size());
         }
 
     private:
         std::vector<std::vector<Cell>> cells_;
     };
 
+    /// @brief Row major copy of grid's cells, cell (x, y) at y * width + x
+    std::vector<Cell> flatten(const Grid &grid);
+
+    /// @brief A beam on a grid addressed by Index, which may be unsigned
+    template <typename Index>
+    struct BeamAt
+    {
+        Index x;
+        Index y;
+        Direction direction;
+    };
+
+    /// @brief The beam walk shared by the flat tracers.
+    ///
+    /// Pops every beam off beams and calls enter(x, y, direction), which
+    /// returns the cell there, or nothing when that state was walked before.
+    /// The exits of a newly entered cell that are still on the grid are
+    /// pushed onto next.  Passing the same vector twice walks depth first
+    /// until no beam is left; separate vectors advance a breadth first front
+    /// by one step.  Beams must start on the grid.
+    template <typename Index, typename Enter>
+    void walk_beams(std::vector<BeamAt<Index>> &beams, std::vector<BeamAt<Index>> &next, Index width, Index height, Enter &&enter)
+    {
+        using Unsigned = std::make_unsigned_t<Index>;
+        while (!beams.empty())
+        {
+            auto beam = beams.back();
+            beams.pop_back();
+            std::optional<Cell> cell = enter(beam.x, beam.y, beam.direction);
+            if (!cell)
+            {
+                continue;
+            }
+            const auto &leaving = exits(*cell, beam.direction);
+            for (std::size_t i = 0; i < leaving.count; ++i)
+            {
+                auto [dx, dy] = delta(leaving.directions[i]);
+                auto x = static_cast<Index>(beam.x + static_cast<Index>(dx));
+                auto y = static_cast<Index>(beam.y + static_cast<Index>(dy));
+                // Stepping off the low edge wraps around, so one unsigned compare checks both sides
+                if (static_cast<Unsigned>(x) < static_cast<Unsigned>(width) && static_cast<Unsigned>(y) < static_cast<Unsigned>(height))
+                {
+                    next.push_back({x, y, leaving.directions[i]});
+                }
+            }
+        }
+    }
+
+    /// @brief trace_grid for any grid type with width(), height() and cell(x, y),
+    /// keeping one byte of visited direction bits per cell
+    template <typename AnyGrid>
+    std::size_t trace_cells(const AnyGrid &grid, const XY &entry_location, const Direction &entry_direction)
+    {
+        auto [entry_x, entry_y] = entry_location;
+        const Coord width = grid.width();
+        const Coord height = grid.height();
+        if (entry_x < 0 || entry_y < 0 || entry_x >= width || entry_y >= height)
+        {
+            return 0;
+        }
+        std::vector<std::uint8_t> visited(static_cast<std::size_t>(width * height), 0);
+        std::size_t energized = 0;
+        std::vector<BeamAt<Coord>> beams = {{entry_x, entry_y, entry_direction}};
+        walk_beams(beams, beams, width, height, [&](Coord x, Coord y, Direction direction) -> std::optional<Cell>
+                   {
+            auto &seen = visited[static_cast<std::size_t>(y * width + x)];
+            auto bit = static_cast<std::uint8_t>(1 << static_cast<int>(direction));
+            if (seen & bit)
+            {
+                return std::nullopt;
+            }
+            energized += seen == 0;
+            seen |= bit;
+            return grid.cell(x, y); });
+        return energized;
+    }
+
     /// @brief Given a location, direction of entry, and cell, compute all next possible locations
     /// @param cur_location
     /// @param cur_direction
@@ -108,9 +208,11 @@ namespace cells
     {
     protected:
         std::vector<std::vector<SpaceDirections>> grid_;
+        // Cells with at least one direction, kept up to date by visit
+        std::size_t occupied_ = 0;
 
     public:
-        OccupyGrid(int width, int height)
+        OccupyGrid(Coord width, Coord height)
         {
             grid_.resize(height);
             for (auto &row : grid_)
@@ -127,24 +229,70 @@ namespace cells
             {
                 return false;
             }
+            if (directions.empty())
+            {
+                occupied_++;
+            }
             directions.insert(direction);
             return true;
         }
-        std::size_t occupied_count()
+        std::size_t occupied_count() const
         {
-            std::size_t count = 0;
-            for (auto &row : grid_)
-            {
-                for (auto &cell : row)
-                {
-                    if(!cell.empty()) {
-                        count++;
-                    }
-                }
-            }
-            return count;
+            return occupied_;
         }
     };
 
     std::size_t trace_grid(const Grid &grid, const XY &entry_location, const Direction &entry_direction);
-}
\ No newline at end of file
+
+    /// @brief Cells energized by the union of several light sources
+    ///
+    /// Every source is seeded into one frontier sharing a single OccupyGrid, so
+    /// a path reached from more than one source is walked once.
+    std::size_t trace_grid(const Grid &grid, std::span<const Beam> sources);
+
+    /// @brief Whether trace_grid from this entry would energize more than threshold cells
+    ///
+    /// Stops as soon as the running occupied count passes threshold, so a
+    /// large trace is only walked until it is known to be large.
+    bool trace_exceeds(const Grid &grid, const XY &entry_location, const Direction &entry_direction, std::size_t threshold);
+
+    /// @brief Cooperative stop request shared between a trace and whoever wants it stopped
+    class CancellationToken
+    {
+    public:
+        void cancel()
+        {
+            cancelled_.store(true, std::memory_order_relaxed);
+        }
+        bool cancelled() const
+        {
+            return cancelled_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        std::atomic<bool> cancelled_{false};
+    };
+
+    /// @brief Optional bounds on a long trace, polled every check_interval beam steps
+    struct TraceLimits
+    {
+        const CancellationToken *cancel = nullptr;
+        std::optional<std::chrono::steady_clock::time_point> deadline;
+        /// Beam steps between checks, keeps the clock read off the hot path
+        std::size_t check_interval = 4096;
+        /// Called at every check with the steps taken and cells energized so far
+        std::function<void(std::size_t steps, std::size_t energized)> progress;
+    };
+
+    struct TraceResult
+    {
+        /// Cells energized, a lower bound when the trace is incomplete
+        std::size_t energized = 0;
+        /// False when the trace was cancelled or ran past its deadline
+        bool complete = true;
+        std::size_t steps = 0;
+    };
+
+    /// @brief trace_grid that stops early, with a partial result, when limits says so
+    TraceResult trace_grid(const Grid &grid, const XY &entry_location, const Direction &entry_direction, const TraceLimits &limits);
+}
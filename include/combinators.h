@@ -0,0 +1,148 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <tuple>
+#include <utility>
+#include "frame_task.h"
+#include "state_machine.h"
+
+namespace state_machine
+{
+    /// @brief Pollable that completes once predicate() returns true.
+    template <typename Predicate>
+    class Until
+    {
+    public:
+        explicit Until(Predicate predicate) : predicate(std::move(predicate)) {}
+        bool poll()
+        {
+            return predicate();
+        }
+
+    private:
+        Predicate predicate;
+    };
+
+    template <typename Predicate>
+    Until<Predicate> until(Predicate predicate)
+    {
+        return Until<Predicate>(std::move(predicate));
+    }
+
+    inline auto button_pressed(IIO &io)
+    {
+        return until([&io]
+                     { return io.button_pressed(); });
+    }
+    inline auto button_released(IIO &io)
+    {
+        return until([&io]
+                     { return io.button_released(); });
+    }
+    inline auto timer_expired(const ITimer &timer)
+    {
+        return until([&timer]
+                     { return timer.expired(); });
+    }
+
+    /// @brief Races several Pollables.  Completes when the first one does, and
+    /// result() is its index.  Operations are polled in argument order, so an
+    /// earlier one wins a tie.  Losers are simply dropped with the combinator.
+    template <Pollable... Ops>
+    class WhenAny
+    {
+    public:
+        explicit WhenAny(Ops... ops) : ops(std::move(ops)...) {}
+        bool poll()
+        {
+            return poll_from(std::index_sequence_for<Ops...>{});
+        }
+        std::size_t result() const
+        {
+            return winner;
+        }
+
+    private:
+        template <std::size_t... I>
+        bool poll_from(std::index_sequence<I...>)
+        {
+            // Fold stops at the first operation that completes
+            return ((std::get<I>(ops).poll() ? (winner = I, true) : false) || ...);
+        }
+
+        std::tuple<Ops...> ops;
+        std::size_t winner = sizeof...(Ops);
+    };
+
+    /// @brief Completes once every Pollable has.  Finished ones are not polled again.
+    template <Pollable... Ops>
+    class WhenAll
+    {
+    public:
+        explicit WhenAll(Ops... ops) : ops(std::move(ops)...) {}
+        bool poll()
+        {
+            poll_each(std::index_sequence_for<Ops...>{});
+            return remaining == 0;
+        }
+
+    private:
+        template <std::size_t... I>
+        void poll_each(std::index_sequence<I...>)
+        {
+            ((!finished[I] && std::get<I>(ops).poll() ? (finished[I] = true, remaining--) : 0), ...);
+        }
+
+        std::tuple<Ops...> ops;
+        std::array<bool, sizeof...(Ops)> finished{};
+        std::size_t remaining = sizeof...(Ops);
+    };
+
+    /// @brief Races a Pollable against a timer, which is reset to seconds when
+    /// this is created.  result() is true if the operation finished first.
+    template <Pollable Op>
+    class WithTimeout
+    {
+    public:
+        WithTimeout(Op op, ITimer &timer, double seconds) : op(std::move(op)), timer(timer)
+        {
+            timer.reset(seconds);
+        }
+        bool poll()
+        {
+            if (op.poll())
+            {
+                completed = true;
+                return true;
+            }
+            return timer.expired();
+        }
+        bool result() const
+        {
+            return completed;
+        }
+
+    private:
+        Op op;
+        ITimer &timer;
+        bool completed = false;
+    };
+
+    template <Pollable... Ops>
+    WhenAny<std::decay_t<Ops>...> when_any(Ops &&...ops)
+    {
+        return WhenAny<std::decay_t<Ops>...>(std::forward<Ops>(ops)...);
+    }
+
+    template <Pollable... Ops>
+    WhenAll<std::decay_t<Ops>...> when_all(Ops &&...ops)
+    {
+        return WhenAll<std::decay_t<Ops>...>(std::forward<Ops>(ops)...);
+    }
+
+    template <Pollable Op>
+    WithTimeout<std::decay_t<Op>> with_timeout(Op &&op, ITimer &timer, double seconds)
+    {
+        return WithTimeout<std::decay_t<Op>>(std::forward<Op>(op), timer, seconds);
+    }
+}
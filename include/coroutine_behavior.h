@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include "frame_task.h"
+#include "state_machine.h"
+
+namespace state_machine
+{
+    /// @brief Coroutine version of PolledButtonBehavior.
+    /// The body reads like the blocking start(), but every wait suspends until
+    /// the next call to do_work instead of spinning.
+    class CoroutineButtonBehavior
+    {
+    public:
+        using States = PolledButtonBehavior::States;
+
+        CoroutineButtonBehavior(IIO &io, ITimer &timer) : io(io), timer(timer), task(run()) {}
+        CoroutineButtonBehavior(const CoroutineButtonBehavior &) = delete;
+        CoroutineButtonBehavior &operator=(const CoroutineButtonBehavior &) = delete;
+
+        void do_work()
+        {
+            task.resume();
+        }
+
+        States get_state() const
+        {
+            return current_state;
+        }
+
+        /// @brief Size in bytes of the heap allocated coroutine frame backing each instance
+        static std::size_t frame_size();
+
+    protected:
+        FrameTask run();
+
+        States current_state = States::NotPressed;
+        IIO &io;
+        ITimer &timer;
+        FrameTask task;
+    };
+}
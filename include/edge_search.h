@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "beam_graph.h"
+#include "multi_trace.h"
+
+namespace cells
+{
+    /// @brief Energized count of every edge entry of a grid
+    struct EdgeSweep
+    {
+        /// In edge_entries() order
+        std::vector<Entry> entries;
+        std::vector<std::size_t> energized;
+        /// Traces run from a splitter, one per group, at most entries.size()
+        std::size_t full_traces = 0;
+
+        /// @brief Index of the entry with the highest count, first one on ties
+        std::size_t best() const;
+    };
+
+    /// @brief Trace every edge entry, sharing work between entries that reach
+    /// the same splitter.
+    ///
+    /// Until it splits, an entry is a single beam through space and mirrors.
+    /// Once it hits the flat side of a splitter, what follows depends only on
+    /// that splitter, so entries are grouped by the first splitter they
+    /// reach and each group is traced once.  An entry's count is the group's
+    /// count plus the cells of its own path to the splitter that the group did
+    /// not already energize.  Entries that never split are just their path.
+    EdgeSweep sweep_edges(const Grid &grid);
+
+    /// @brief The k edge entries with the highest energized counts
+    struct TopEdges
+    {
+        /// Highest count first
+        std::vector<Entry> entries;
+        std::vector<std::size_t> energized;
+        /// Entries whose exact count was formed, the rest were pruned
+        std::size_t exact_traces = 0;
+    };
+
+    /// @brief Find the k best edge entries without forming every exact count.
+    ///
+    /// Entries are visited in decreasing BeamGraph::upper_bound order, and the
+    /// search stops once the next bound cannot beat the current k-th best.
+    /// Which of several equal counts make the cut is unspecified.
+    TopEdges top_edges(const BeamGraph &graph, std::size_t k);
+}
@@ -0,0 +1,235 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "state_machine.h"
+
+namespace state_machine
+{
+    using SignalId = std::size_t;
+
+    /// @brief Signals a behavior is blocked on.  Empty means "run me every frame".
+    class WaitSet
+    {
+    public:
+        static constexpr std::size_t capacity = 4;
+
+        void add(SignalId signal)
+        {
+            if (size_ == capacity)
+            {
+                throw std::runtime_error("WaitSet holds at most " + std::to_string(capacity) + " signals");
+            }
+            signals_[size_++] = signal;
+        }
+        void clear()
+        {
+            size_ = 0;
+        }
+        bool empty() const
+        {
+            return size_ == 0;
+        }
+        const SignalId *begin() const
+        {
+            return signals_.data();
+        }
+        const SignalId *end() const
+        {
+            return signals_.data() + size_;
+        }
+
+    private:
+        std::array<SignalId, capacity> signals_{};
+        std::size_t size_ = 0;
+    };
+
+    /// @brief A behavior that can tell the executive what it is waiting for.
+    class IWaitingBehavior
+    {
+    public:
+        virtual ~IWaitingBehavior() = default;
+        virtual void do_work() = 0;
+        /// @brief Called after do_work, fill in the signals that must change before there is more work
+        virtual void waiting_on(WaitSet &set) const = 0;
+    };
+
+    /// @brief Frame executive that only runs behaviors whose inputs changed.
+    ///
+    /// Every input (button edge, timer expiry, ...) is a signal with a version.
+    /// After a behavior runs it subscribes to the signals it waits on, and it is
+    /// not run again until one of them changes.  Per-frame cost is proportional
+    /// to the number of signals that fired, not the number of behaviors.
+    class Executive
+    {
+    public:
+        /// @brief ITimer whose expiry is a signal, driven by the executive's frame time
+        class Timer : public ITimer
+        {
+        public:
+            Timer(Executive &executive, SignalId signal) : executive(executive), signal_(signal) {}
+            ITimer &reset(double seconds) override;
+            bool expired() const override
+            {
+                return executive.now() >= deadline_;
+            }
+            SignalId signal() const
+            {
+                return signal_;
+            }
+
+        private:
+            friend class Executive;
+            Executive &executive;
+            SignalId signal_;
+            double deadline_ = 0.0;
+            std::uint64_t generation_ = 0;
+        };
+
+        SignalId add_signal();
+        /// @brief Mark an input as changed, waking everything waiting on it
+        void signal(SignalId signal);
+        /// @brief Sequence number of the last change to a signal, 0 if it never changed
+        std::uint64_t version(SignalId signal) const
+        {
+            return signals_[signal].version;
+        }
+
+        /// @brief Subscriptions held for a signal, including ones already stale
+        std::size_t waiter_count(SignalId signal) const
+        {
+            return signals_[signal].waiters.size();
+        }
+
+        Timer &add_timer();
+
+        /// @brief Add a behavior, which is run on the next frame.  The behavior must outlive the executive.
+        void add(IWaitingBehavior &behavior);
+
+        /// @brief Fire timers expired at time now and run every behavior that has something to do
+        void frame(double now);
+
+        double now() const
+        {
+            return now_;
+        }
+        /// @brief Total number of do_work calls made
+        std::size_t runs() const
+        {
+            return runs_;
+        }
+
+    private:
+        struct Subscription
+        {
+            std::size_t behavior;
+            std::uint64_t epoch;
+        };
+        struct SignalState
+        {
+            std::uint64_t version = 0;
+            std::vector<Subscription> waiters;
+        };
+        struct BehaviorState
+        {
+            IWaitingBehavior *behavior;
+            // Bumped on every run so subscriptions from earlier runs are ignored
+            std::uint64_t epoch = 0;
+            // Signal sequence number when the last run started
+            std::uint64_t started = 0;
+            bool ready = false;
+        };
+        struct Wakeup
+        {
+            double time;
+            Timer *timer;
+            std::uint64_t generation;
+
+            bool operator>(const Wakeup &other) const
+            {
+                return time > other.time;
+            }
+        };
+
+        void make_ready(std::size_t behavior);
+        void subscribe(SignalState &signal, std::size_t behavior);
+        void schedule(Timer &timer);
+
+        double now_ = 0.0;
+        std::uint64_t sequence_ = 0;
+        std::size_t runs_ = 0;
+        std::vector<SignalState> signals_;
+        std::vector<BehaviorState> behaviors_;
+        std::vector<std::size_t> ready_;
+        std::vector<std::size_t> running_;
+        std::deque<Timer> timers_;
+        std::priority_queue<Wakeup, std::vector<Wakeup>, std::greater<Wakeup>> wakeups_;
+        WaitSet wait_set_;
+    };
+
+    /// @brief IIO whose button is latched and only signals the executive on an edge.
+    class LatchedButtonIO : public IIO
+    {
+    public:
+        LatchedButtonIO(Executive &executive) : executive(executive), button_signal_(executive.add_signal()) {}
+
+        /// @brief Update the button reading, signaling only when it changes
+        void set_button(bool pressed)
+        {
+            if (pressed != button_pressed_value)
+            {
+                button_pressed_value = pressed;
+                executive.signal(button_signal_);
+            }
+        }
+        SignalId button_signal() const
+        {
+            return button_signal_;
+        }
+
+        void set_light(OnOff on_or_off) override
+        {
+            light_value = on_or_off;
+        }
+        bool button_pressed() override
+        {
+            return button_pressed_value;
+        }
+        bool button_released() override
+        {
+            return !button_pressed_value;
+        }
+
+        OnOff light_value = OnOff::Off;
+
+    private:
+        Executive &executive;
+        SignalId button_signal_;
+        bool button_pressed_value = false;
+    };
+
+    /// @brief PolledButtonBehavior wired to an executive, waiting on the button
+    /// edge and, while blinking, its timer.
+    class ScheduledButtonBehavior : public IWaitingBehavior
+    {
+    public:
+        ScheduledButtonBehavior(Executive &executive)
+            : io(executive), timer(executive.add_timer()), behavior(io, timer) {}
+
+        void do_work() override
+        {
+            behavior.do_work();
+        }
+        void waiting_on(WaitSet &set) const override;
+
+        LatchedButtonIO io;
+        Executive::Timer &timer;
+        PolledButtonBehavior behavior;
+    };
+}
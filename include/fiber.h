@@ -0,0 +1,160 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "state_machine.h"
+
+namespace state_machine
+{
+    /// @brief Fixed size fiber stacks with a guard page, kept on a free list for reuse.
+    class FiberStackPool
+    {
+    public:
+        explicit FiberStackPool(std::size_t stack_size);
+        FiberStackPool(const FiberStackPool &) = delete;
+        FiberStackPool &operator=(const FiberStackPool &) = delete;
+        ~FiberStackPool();
+
+        /// @brief Lowest usable address of a stack of stack_size() bytes
+        void *acquire();
+        void release(void *stack);
+
+        std::size_t stack_size() const
+        {
+            return stack_size_;
+        }
+        /// @brief Stacks mapped so far, in use or free
+        std::size_t mapped() const
+        {
+            return mapped_.size();
+        }
+
+    private:
+        std::size_t stack_size_;
+        std::size_t guard_size_;
+        std::vector<void *> mapped_;
+        std::vector<void *> free_;
+    };
+
+    /// @brief Runs blocking style code, like start(), as fibers on one thread.
+    ///
+    /// Each fiber has its own small stack and runs until it calls yield(), which
+    /// switches straight back to the scheduler.  round() resumes every live fiber
+    /// once in spawn order.  On x86-64 the switch saves only the callee saved
+    /// registers, elsewhere it falls back to ucontext.
+    ///
+    /// Fibers still running when the scheduler is destroyed are cancelled:
+    /// their pending yield() throws, unwinding their stacks so destructors run.
+    class FiberScheduler
+    {
+    public:
+        explicit FiberScheduler(std::size_t stack_size = 32 * 1024);
+        FiberScheduler(const FiberScheduler &) = delete;
+        FiberScheduler &operator=(const FiberScheduler &) = delete;
+        ~FiberScheduler();
+
+        /// @brief Add a fiber, first run on the next round()
+        void spawn(std::function<void()> body);
+
+        /// @brief Resume every live fiber until it yields or returns
+        /// @return number of fibers still alive
+        std::size_t round();
+
+        /// @brief Give control back to the scheduler until the next round.
+        /// Must be called from inside a fiber.
+        static void yield();
+
+        /// @brief Number of completed rounds
+        std::uint64_t rounds() const
+        {
+            return rounds_;
+        }
+        /// @brief Fibers that have not returned yet
+        std::size_t size() const
+        {
+            return fibers_.size();
+        }
+        const FiberStackPool &stacks() const
+        {
+            return stacks_;
+        }
+
+        struct Fiber;
+
+    private:
+        void resume(Fiber &fiber);
+
+        FiberStackPool stacks_;
+        std::vector<std::unique_ptr<Fiber>> fibers_;
+        std::uint64_t rounds_ = 0;
+    };
+
+    /// @brief IIO adapter for blocking code running in a fiber.  Asking the same
+    /// question twice in one round means the caller is spinning, so the second
+    /// ask yields first.  Every input is still read at most once per round.
+    class FiberIO : public IIO
+    {
+    public:
+        FiberIO(FiberScheduler &scheduler, IIO &io) : scheduler(scheduler), io(io) {}
+
+        void set_light(OnOff on_or_off) override
+        {
+            io.set_light(on_or_off);
+        }
+        bool button_pressed() override
+        {
+            spin_check(pressed_round);
+            return io.button_pressed();
+        }
+        bool button_released() override
+        {
+            spin_check(released_round);
+            return io.button_released();
+        }
+
+    private:
+        void spin_check(std::uint64_t &asked_round)
+        {
+            if (asked_round == scheduler.rounds() + 1)
+            {
+                FiberScheduler::yield();
+            }
+            asked_round = scheduler.rounds() + 1;
+        }
+
+        FiberScheduler &scheduler;
+        IIO &io;
+        // rounds() + 1 while a round is running, so 0 never matches
+        std::uint64_t pressed_round = 0;
+        std::uint64_t released_round = 0;
+    };
+
+    /// @brief ITimer adapter for blocking code running in a fiber, see FiberIO
+    class FiberTimer : public ITimer
+    {
+    public:
+        FiberTimer(FiberScheduler &scheduler, ITimer &timer) : scheduler(scheduler), timer(timer) {}
+
+        ITimer &reset(double seconds) override
+        {
+            timer.reset(seconds);
+            return *this;
+        }
+        bool expired() const override
+        {
+            if (asked_round == scheduler.rounds() + 1)
+            {
+                FiberScheduler::yield();
+            }
+            asked_round = scheduler.rounds() + 1;
+            return timer.expired();
+        }
+
+    private:
+        FiberScheduler &scheduler;
+        ITimer &timer;
+        mutable std::uint64_t asked_round = 0;
+    };
+}
@@ -0,0 +1,130 @@
+#pragma once
+#include <coroutine>
+#include <cstddef>
+#include <type_traits>
+#include "frame_task.h"
+
+namespace state_machine
+{
+    /// @brief Resumes coroutines that yielded until the next frame.
+    ///
+    /// co_await pool.next_frame() parks the coroutine on an intrusive list whose
+    /// links live in the awaiter, inside the suspended coroutine frame, so
+    /// yielding never allocates.  frame() resumes exactly the coroutines parked
+    /// before it was called, one resume each, and nothing else.
+    ///
+    /// A FrameTask parked here ignores its own resume(), the pool drives it.
+    /// Destroying a parked coroutine unlinks it.  The pool must outlive every
+    /// coroutine parked on it and cannot be moved.
+    class FramePool
+    {
+    public:
+        /// @brief Doubly linked so a parked coroutine can be removed in O(1)
+        struct Link
+        {
+            Link *prev = nullptr;
+            Link *next = nullptr;
+
+            bool linked() const
+            {
+                return next != nullptr;
+            }
+            void unlink()
+            {
+                if (linked())
+                {
+                    prev->next = next;
+                    next->prev = prev;
+                    prev = next = nullptr;
+                }
+            }
+        };
+
+        class FrameAwaiter : public Link
+        {
+        public:
+            explicit FrameAwaiter(FramePool &pool) : pool(pool) {}
+            /// @brief Only ever moved before it is parked, as it is passed to co_await
+            FrameAwaiter(FrameAwaiter &&other) noexcept : Link(), pool(other.pool) {}
+            FrameAwaiter &operator=(const FrameAwaiter &) = delete;
+            ~FrameAwaiter()
+            {
+                if (linked())
+                {
+                    unlink();
+                    pool.count--;
+                }
+            }
+
+            bool await_ready() const
+            {
+                return false;
+            }
+            template <typename Promise>
+            void await_suspend(std::coroutine_handle<Promise> handle)
+            {
+                this->handle = handle;
+                if constexpr (std::is_same_v<Promise, FrameTask::promise_type>)
+                {
+                    // Keep FrameTask::resume from running the coroutine before the pool does
+                    blocked = &handle.promise().blocked;
+                    *blocked = {this, [](void *)
+                                { return false; }};
+                }
+                pool.park(*this);
+            }
+            void await_resume() {}
+
+        private:
+            friend class FramePool;
+            FramePool &pool;
+            std::coroutine_handle<> handle;
+            FrameTask::promise_type::Blocker *blocked = nullptr;
+        };
+
+        FramePool()
+        {
+            parked.prev = parked.next = &parked;
+        }
+        FramePool(const FramePool &) = delete;
+        FramePool &operator=(const FramePool &) = delete;
+        ~FramePool();
+
+        /// @brief Suspend the awaiting coroutine until the next frame()
+        FrameAwaiter next_frame()
+        {
+            return FrameAwaiter(*this);
+        }
+
+        /// @brief Resume every coroutine parked before this call.  Coroutines
+        /// that yield again while it runs wait for the following frame.
+        /// @return number of coroutines resumed
+        std::size_t frame();
+
+        /// @brief Number of coroutines waiting for the next frame
+        std::size_t size() const
+        {
+            return count;
+        }
+        bool empty() const
+        {
+            return count == 0;
+        }
+
+    private:
+        void park(FrameAwaiter &awaiter)
+        {
+            awaiter.prev = parked.prev;
+            awaiter.next = &parked;
+            parked.prev->next = &awaiter;
+            parked.prev = &awaiter;
+            count++;
+        }
+
+        // Sentinel of a circular list, in resume order
+        Link parked;
+        // Placed after the last coroutine parked when frame() starts
+        Link marker;
+        std::size_t count = 0;
+    };
+}
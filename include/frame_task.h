@@ -0,0 +1,159 @@
+#pragma once
+#include <concepts>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <type_traits>
+#include <utility>
+
+namespace state_machine
+{
+    /// @brief Anything that can be polled once per frame until it completes.
+    /// poll() returns true once the operation is done, after which result()
+    /// (if present) gives its value.
+    template <typename T>
+    concept Pollable = requires(T &op) {
+        { op.poll() } -> std::convertible_to<bool>;
+    };
+
+    /// @brief Free lists of coroutine frames, so starting a coroutine in steady
+    /// state reuses a previous frame instead of allocating.  Per thread, no locking.
+    class FrameRecycler
+    {
+    public:
+        static void *allocate(std::size_t size);
+        static void release(void *frame, std::size_t size);
+        /// @brief Frames cached on this thread's free lists
+        static std::size_t cached();
+
+        /// Frames kept per size class, further releases are freed
+        static constexpr std::size_t max_cached = 256;
+
+    private:
+        static constexpr std::size_t granularity = 64;
+        static constexpr std::size_t classes = 16;
+    };
+
+    /// @brief Coroutine handle owner for frame based behaviors.
+    /// The coroutine does not start until the first resume().  Inside the body,
+    /// co_await std::suspend_always{} gives control back until the next frame, and
+    /// co_await on a Pollable blocks until a later resume() finds it complete.
+    class FrameTask
+    {
+    public:
+        struct promise_type
+        {
+            /// Type erased Pollable the coroutine is blocked on, checked before resuming it
+            struct Blocker
+            {
+                void *op = nullptr;
+                bool (*poll)(void *) = nullptr;
+            };
+
+            template <typename Op>
+            struct PollAwaiter
+            {
+                Op op;
+
+                bool await_ready()
+                {
+                    return op.poll();
+                }
+                void await_suspend(std::coroutine_handle<promise_type> handle)
+                {
+                    handle.promise().blocked = {&op, [](void *op)
+                                                { return static_cast<bool>(static_cast<std::remove_reference_t<Op> *>(op)->poll()); }};
+                }
+                decltype(auto) await_resume()
+                {
+                    if constexpr (requires { op.result(); })
+                    {
+                        return op.result();
+                    }
+                }
+            };
+
+            FrameTask get_return_object()
+            {
+                return FrameTask(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            std::suspend_always final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+
+            template <Pollable Op>
+            PollAwaiter<Op> await_transform(Op &&op)
+            {
+                return PollAwaiter<Op>{std::forward<Op>(op)};
+            }
+            template <typename Awaitable>
+                requires(!Pollable<Awaitable>)
+            Awaitable &&await_transform(Awaitable &&awaitable)
+            {
+                return std::forward<Awaitable>(awaitable);
+            }
+
+            // Track coroutine frame sizes so memory per behavior can be reported.
+            // Per thread, like FrameRecycler, so allocations on other threads never race.
+            static void *operator new(std::size_t size)
+            {
+                last_frame_size = size;
+                return FrameRecycler::allocate(size);
+            }
+            static void operator delete(void *frame, std::size_t size)
+            {
+                FrameRecycler::release(frame, size);
+            }
+            static inline thread_local std::size_t last_frame_size = 0;
+
+            Blocker blocked;
+        };
+
+        FrameTask(FrameTask &&other) noexcept : handle(other.handle)
+        {
+            other.handle = nullptr;
+        }
+        FrameTask(const FrameTask &) = delete;
+        FrameTask &operator=(const FrameTask &) = delete;
+        ~FrameTask()
+        {
+            if (handle)
+            {
+                handle.destroy();
+            }
+        }
+
+        /// @brief Run the coroutine until its next suspension point, unless it is
+        /// blocked on a Pollable that is still not complete
+        void resume()
+        {
+            if (!handle || handle.done())
+            {
+                return;
+            }
+            auto &blocked = handle.promise().blocked;
+            if (blocked.poll && !blocked.poll(blocked.op))
+            {
+                return;
+            }
+            blocked = {};
+            handle.resume();
+        }
+        bool done() const
+        {
+            return !handle || handle.done();
+        }
+
+        /// @brief A FrameTask is itself Pollable, so one coroutine can run another
+        bool poll()
+        {
+            resume();
+            return done();
+        }
+
+    private:
+        explicit FrameTask(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+        std::coroutine_handle<promise_type> handle;
+    };
+}
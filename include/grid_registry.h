@@ -0,0 +1,89 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "mapped_grid.h"
+
+namespace cells
+{
+    /// @brief First page of a shared grid segment, the tile image follows at
+    /// the next page.  Never written after publishing.
+    struct SharedGridHeader
+    {
+        char magic[8];
+        std::uint64_t version;
+    };
+
+    /// @brief A grid published by GridRegistry, mapped read-only.
+    ///
+    /// Counts itself in the version's reader count for as long as it lives.
+    /// A newer publish does not disturb it: the old segment stays mapped
+    /// until its last reader goes away.  A process that dies without
+    /// destroying it leaves readers one high; the memory is still freed by
+    /// the kernel.
+    class SharedGrid
+    {
+    public:
+        SharedGrid(SharedGrid &&other) noexcept;
+        SharedGrid(const SharedGrid &) = delete;
+        SharedGrid &operator=(const SharedGrid &) = delete;
+        ~SharedGrid();
+
+        const MappedGrid &grid() const
+        {
+            return grid_;
+        }
+        std::uint64_t version() const
+        {
+            return header_->version;
+        }
+        /// @brief Open SharedGrids of this version, across all processes
+        std::uint64_t readers() const;
+
+    private:
+        friend class GridRegistry;
+        SharedGrid(const SharedGridHeader *header, std::uint64_t *readers, MappedGrid grid)
+            : header_(header), readers_(readers), grid_(std::move(grid)) {}
+
+        const SharedGridHeader *header_;
+        std::uint64_t *readers_;
+        MappedGrid grid_;
+    };
+
+    /// @brief Parsed grids in named POSIX shared memory, so every process on a
+    /// host maps one copy.
+    ///
+    /// Each publish of a name writes a new version into its own segment,
+    /// `/<prefix>.<name>.<version>`, then points the small `/<prefix>.<name>`
+    /// segment at it and unlinks the version it replaced.  Readers that
+    /// already mapped the old version keep it; the kernel frees it after the
+    /// last one unmaps.  Opening always maps the current version.
+    ///
+    /// Readers only need read access to the grid, so processes of other
+    /// users can open it; nothing they do can change the grid they trace.
+    /// The reader count of a version lives in its own small segment,
+    /// `/<prefix>.<name>.<version>.readers`, which is writable by everyone
+    /// and so only advisory.
+    class GridRegistry
+    {
+    public:
+        explicit GridRegistry(std::string prefix = "cells") : prefix_(std::move(prefix)) {}
+
+        /// @brief Publish grid under name, returning its version, starting at 1
+        std::uint64_t publish(const std::string &name, const Grid &grid, std::uint32_t tile_size = 256);
+        /// @brief Map the current version of name, throws if nothing is published
+        SharedGrid open(const std::string &name) const;
+        /// @brief Current version of name, 0 if nothing is published
+        std::uint64_t current_version(const std::string &name) const;
+        /// @brief Unlink name and its current version.  Open SharedGrids stay valid.
+        void remove(const std::string &name);
+
+    private:
+        std::string index_name(const std::string &name) const;
+        std::string segment_name(const std::string &name, std::uint64_t version) const;
+        /// @brief Unlink a version's grid and reader count
+        void unlink_version(const std::string &name, std::uint64_t version) const;
+
+        std::string prefix_;
+    };
+}
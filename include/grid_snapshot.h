@@ -0,0 +1,120 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+#include "cells.h"
+
+namespace cells
+{
+    /// @brief Immutable version of a grid stored as square tiles.
+    ///
+    /// Tiles are shared between versions, so a snapshot costs one pointer per
+    /// tile plus the tiles that changed since the previous version.  Nothing
+    /// in a snapshot is ever written after it is published, so any number of
+    /// threads may read it without locking.
+    class GridSnapshot
+    {
+    public:
+        using Tile = std::vector<Cell>;
+
+        inline std::optional<Cell> at(Coord x, Coord y) const
+        {
+            if (x < 0 || y < 0 || x >= width_ || y >= height_)
+            {
+                return std::nullopt;
+            }
+            return cell(x, y);
+        }
+        /// @brief Cell at a location known to be on the grid
+        inline Cell cell(Coord x, Coord y) const
+        {
+            const auto &tile = *tiles_[static_cast<std::size_t>((y >> tile_shift_) * tiles_x_ + (x >> tile_shift_))];
+            return tile[static_cast<std::size_t>(((y & tile_mask_) << tile_shift_) + (x & tile_mask_))];
+        }
+        Coord width() const
+        {
+            return width_;
+        }
+        Coord height() const
+        {
+            return height_;
+        }
+        /// @brief Publish count of the GridEditor that made this, starting at 1
+        std::uint64_t version() const
+        {
+            return version_;
+        }
+        /// @brief Whether both snapshots hold the very same tile, not just equal cells
+        bool shares_tile(const GridSnapshot &other, std::size_t tile) const
+        {
+            return tiles_[tile] == other.tiles_[tile];
+        }
+        std::size_t tile_count() const
+        {
+            return tiles_.size();
+        }
+
+    private:
+        friend class GridEditor;
+        GridSnapshot() = default;
+
+        Coord width_ = 0;
+        Coord height_ = 0;
+        unsigned tile_shift_ = 0;
+        Coord tile_mask_ = 0;
+        Coord tiles_x_ = 0;
+        std::uint64_t version_ = 0;
+        std::vector<std::shared_ptr<const Tile>> tiles_;
+    };
+
+    /// @brief The single writer of a versioned grid.
+    ///
+    /// Edits go to a working copy whose tiles start out shared with the last
+    /// published snapshot; the first edit of a tile after a publish copies
+    /// just that tile.  publish() freezes the working copy into a new snapshot
+    /// and swaps it in atomically, so readers calling current() see either
+    /// the old version or the new one, never a mix, and keep the version they
+    /// hold alive for as long as they trace it.
+    ///
+    /// The swap is not lock-free: std::atomic<std::shared_ptr> guards the
+    /// pointer with a short internal lock (is_lock_free() is false with
+    /// libstdc++), so current() and publish() may briefly wait on each other
+    /// while a pointer is copied and its count updated.  Tracing a snapshot
+    /// takes no lock at all.
+    class GridEditor
+    {
+    public:
+        /// @brief Start from grid, published as version 1.  tile_size must be a power of two.
+        explicit GridEditor(const Grid &grid, std::uint32_t tile_size = 64);
+
+        /// @brief Change a cell in the working copy, invisible to readers until publish()
+        void set(Coord x, Coord y, Cell cell);
+        /// @brief Make the working copy the current snapshot
+        std::shared_ptr<const GridSnapshot> publish();
+        /// @brief Latest published snapshot, safe to call from any thread.
+        /// Takes the atomic's internal lock for the pointer copy only.
+        std::shared_ptr<const GridSnapshot> current() const
+        {
+            return current_.load(std::memory_order_acquire);
+        }
+
+        /// @brief Tiles copied by set() since the last publish
+        std::size_t copied_tiles() const
+        {
+            return copied_;
+        }
+
+    private:
+        GridSnapshot working_;
+        // Tiles of working_ written since the last publish, not shared with any snapshot
+        std::vector<std::shared_ptr<GridSnapshot::Tile>> owned_;
+        std::size_t copied_ = 0;
+        std::atomic<std::shared_ptr<const GridSnapshot>> current_;
+    };
+
+    /// @brief Same result as trace_grid on the equivalent Grid
+    std::size_t trace_grid(const GridSnapshot &grid, const XY &entry_location, const Direction &entry_direction);
+}
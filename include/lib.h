@@ -5,5 +5,12 @@
 namespace lib
 {
     const char *sample_data();
-    cells::Grid lines_to_grid(const std::string &lines);
+    /// @brief Parse grid text, one row per line.  Inputs of several megabytes are
+    /// split at row boundaries and parsed on up to threads threads, 0 meaning
+    /// one per core.  Throws if rows differ in width or hold unknown characters.
+    cells::Grid lines_to_grid(const std::string &lines, unsigned threads = 0);
+    /// @brief Grid as text lines_to_grid reads back, every row ending in a newline
+    std::string grid_to_lines(const cells::Grid &grid);
+    /// @brief Grid where each cell is a random non-space cell with probability obstacle_fraction
+    cells::Grid random_grid(cells::Coord width, cells::Coord height, double obstacle_fraction, unsigned seed);
 }
\ No newline at end of file
@@ -0,0 +1,116 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include "cells.h"
+
+namespace cells
+{
+    /// @brief Header of a tiled grid file.  Tiles of tile_size x tile_size cells,
+    /// one byte per cell, follow in row-major tile order.  Edge tiles are padded
+    /// with Space so every tile has the same size.
+    struct TileFileHeader
+    {
+        char magic[8];
+        std::uint64_t width;
+        std::uint64_t height;
+        std::uint32_t tile_size;
+        std::uint32_t reserved;
+    };
+
+    /// @brief Fill one tile, given its tile column, tile row, and tile_size * tile_size cells
+    using TileFiller = std::function<void(std::uint64_t tile_x, std::uint64_t tile_y, std::span<Cell> cells)>;
+
+    /// @brief Write a tiled grid file one tile at a time, so grids larger than RAM can be produced.
+    /// tile_size must be a power of two.
+    void write_tile_file(const std::string &path, Coord width, Coord height, std::uint32_t tile_size, const TileFiller &fill);
+    void write_tile_file(const std::string &path, const Grid &grid, std::uint32_t tile_size = 256);
+
+    /// @brief Bytes of a tile file for a width x height grid, header included
+    std::uint64_t tile_image_size(Coord width, Coord height, std::uint32_t tile_size);
+    /// @brief Write the same bytes as write_tile_file into memory, out must hold tile_image_size
+    void write_tile_image(std::span<std::uint8_t> out, const Grid &grid, std::uint32_t tile_size = 256);
+
+    /// @brief Read-only grid backed by a memory mapped tile file.
+    /// The OS pages tiles in on demand and can drop them again, so the grid does
+    /// not need to fit in RAM.  Tiles keep both horizontal and vertical beams local.
+    class MappedGrid
+    {
+    public:
+        explicit MappedGrid(const std::string &path);
+        /// @brief Map the tile image starting at a page aligned offset of an
+        /// open file or shared memory object.  The caller keeps ownership of fd.
+        MappedGrid(int fd, std::size_t offset, const std::string &name);
+        MappedGrid(MappedGrid &&other) noexcept;
+        MappedGrid(const MappedGrid &) = delete;
+        MappedGrid &operator=(const MappedGrid &) = delete;
+        ~MappedGrid();
+
+        inline std::optional<Cell> at(Coord x, Coord y) const
+        {
+            if (x < 0 || y < 0 || x >= width_ || y >= height_)
+            {
+                return std::nullopt;
+            }
+            return cell(cell_index<std::uint64_t>(x, y));
+        }
+        Coord width() const
+        {
+            return width_;
+        }
+        Coord height() const
+        {
+            return height_;
+        }
+        /// @brief Number of cells including tile padding, the range of cell_index
+        std::uint64_t padded_cells() const
+        {
+            return padded_cells_;
+        }
+
+        /// @brief Position of a cell in the file, in tile-major order.  Index only
+        /// needs to be as wide as padded_cells(), letting small grids use 32 bit math.
+        template <typename Index>
+        inline Index cell_index(Index x, Index y) const
+        {
+            const Index shift = static_cast<Index>(tile_shift_);
+            const Index mask = static_cast<Index>(tile_size_ - 1);
+            Index tile = (y >> shift) * static_cast<Index>(tiles_x_) + (x >> shift);
+            return (tile << (2 * shift)) + ((y & mask) << shift) + (x & mask);
+        }
+        /// @brief Throws on a byte that is not a Cell, the file is not trusted
+        inline Cell cell(std::uint64_t index) const
+        {
+            auto value = cells_[index];
+            if (value > static_cast<std::uint8_t>(Cell::Backslash)) [[unlikely]]
+            {
+                throw std::runtime_error("corrupt cell in tile file");
+            }
+            return static_cast<Cell>(value);
+        }
+
+    private:
+        void map(int fd, std::size_t offset, const std::string &path);
+
+        Coord width_ = 0;
+        Coord height_ = 0;
+        std::uint64_t tile_size_ = 0;
+        unsigned tile_shift_ = 0;
+        std::uint64_t tiles_x_ = 0;
+        std::uint64_t tiles_y_ = 0;
+        std::uint64_t padded_cells_ = 0;
+        void *mapping_ = nullptr;
+        std::size_t mapping_size_ = 0;
+        const std::uint8_t *cells_ = nullptr;
+    };
+
+    /// @brief Trace a MappedGrid.  Visited directions are kept at four bits per
+    /// cell in a lazily committed scratch mapping laid out like the grid's
+    /// tiles, so only the pages near the beams are ever touched.  Uses 32 bit coordinates
+    /// and index math when the grid fits, 64 bit otherwise.
+    std::size_t trace_grid(const MappedGrid &grid, const XY &entry_location, const Direction &entry_direction);
+}
@@ -0,0 +1,169 @@
+#pragma once
+#include <cstddef>
+
+namespace clarity
+{
+    const int NUM_OTHER_VALUES = 16;
+
+    /// @brief Running count of zero valued fields.  Every write reports the old
+    /// and new value, so checking "no field is zero" is O(1).
+    class ZeroFieldCount
+    {
+    public:
+        explicit ZeroFieldCount(std::size_t zeros = 0) : zeros(zeros) {}
+
+        template <typename T>
+        void update(const T &old_value, const T &new_value)
+        {
+            zeros += static_cast<std::size_t>(new_value == 0);
+            zeros -= static_cast<std::size_t>(old_value == 0);
+        }
+        std::size_t count() const
+        {
+            return zeros;
+        }
+        bool none() const
+        {
+            return zeros == 0;
+        }
+
+    private:
+        std::size_t zeros;
+    };
+
+    template <std::size_t NumOtherValues>
+    class BasicModel
+    {
+    private:
+        bool poweron = false;
+        int state1 = 0;
+        int state2 = 0;
+        int state3 = 0;
+        int other_values[NumOtherValues] = {0};
+        // Every field starts at zero
+        ZeroFieldCount zero_fields{3 + NumOtherValues};
+
+        void set(int &field, int value)
+        {
+            zero_fields.update(field, value);
+            field = value;
+        }
+
+    public:
+        void turnPowerOn(bool on = true) { poweron = on; }
+        void setStates(int value)
+        {
+            set(state1, value);
+            set(state2, value);
+            set(state3, value);
+        }
+        void setOtherValues(int value)
+        {
+            for (auto &v : other_values)
+            {
+                set(v, value);
+            }
+        }
+        void setOtherValue(std::size_t index, int value)
+        {
+            set(other_values[index], value);
+        }
+
+        // A state is valid if it is non-zero
+        bool statesValid()
+        {
+            return state1 != 0 && state2 != 0 && state3 != 0;
+        }
+
+        bool poweredOn()
+        {
+            return poweron;
+        }
+
+        bool otherValuesNonZero()
+        {
+            for (const auto &v : other_values)
+            {
+                if (v == 0)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Requirement states that to be valid, the power must be on,
+        // all states have a non-zero value, and all other_values are non-zero.
+        // The zero field count is kept up to date by every setter, so this is O(1).
+        bool isValid()
+        {
+            return poweredOn() && zero_fields.none();
+        }
+
+        // Requirement states that to be valid, the power must be on,
+        // all states have a non-zero value, and all other_values are non-zero.
+        bool isValidOld4()
+        {
+            return poweredOn() && statesValid() && otherValuesNonZero();
+        }
+
+        // Requirement states that to be valid, the power must be on,
+        // all states have a non-zero value, and all other_values are non-zero.
+        bool isValidOld3()
+        {
+            if (!poweron || state1 == 0 || state2 == 0 || state3 == 0)
+            {
+                return false;
+            }
+            for (std::size_t i = 0; i < NumOtherValues; i++)
+            {
+                if (other_values[i] == 0)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Requirement states that to be valid, the power must be on,
+        // all states have a non-zero value, and all other_values are non-zero.
+        bool isValidOld2()
+        {
+            bool valid = true;
+            if (!poweron || state1 == 0 || state2 == 0 || state3 == 0)
+            {
+                valid = false;
+            }
+            for (std::size_t i = 0; i < NumOtherValues; i++)
+            {
+                if (other_values[i] == 0)
+                {
+                    valid = false;
+                    break;
+                }
+            }
+            return valid;
+        }
+
+        // Requirement states that to be valid, the power must be on,
+        // all states have a non-zero value, and all other_values are non-zero.
+        bool isValidOld()
+        {
+            bool valid = true;
+            if (poweron && state1 != 0 && state2 != 0 && state3 != 0)
+            {
+                for (std::size_t i = 0; i < NumOtherValues; i++)
+                {
+                    if (other_values[i] == 0)
+                    {
+                        valid = false;
+                        break;
+                    }
+                }
+            }
+            return valid;
+        }
+    };
+
+    using Model = BasicModel<NUM_OTHER_VALUES>;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "model.h"
+
+namespace clarity
+{
+    /// @brief One bit per model, bit i of word i / 64 is set when model i is valid.
+    using ValidityBitmap = std::vector<std::uint64_t>;
+
+    inline bool is_set(const ValidityBitmap &bitmap, std::size_t index)
+    {
+        return (bitmap[index / 64] >> (index % 64)) & 1;
+    }
+
+    /// @brief Struct-of-arrays storage for many models with the same fields as Model.
+    ///
+    /// Each field is a contiguous column across all models, padded to a multiple
+    /// of 64 models, so validate() can compare 64 models' worth of a field to
+    /// zero with a handful of vector compares and movemasks.
+    class ModelBatch
+    {
+    public:
+        explicit ModelBatch(std::size_t other_value_count = NUM_OTHER_VALUES);
+
+        /// @brief Add a model with power off and every field zero
+        std::size_t add();
+        std::size_t size() const
+        {
+            return size_;
+        }
+
+        void turnPowerOn(std::size_t model, bool on = true)
+        {
+            power_[model] = on;
+        }
+        void setStates(std::size_t model, int value);
+        void setOtherValues(std::size_t model, int value);
+        void setOtherValue(std::size_t model, std::size_t index, int value)
+        {
+            column(state_count + index)[model] = value;
+        }
+
+        /// @brief Same requirement as Model::isValid, for a single model
+        bool isValid(std::size_t model) const;
+
+        /// @brief Validity of every model at once
+        ValidityBitmap validate() const;
+
+    private:
+        static constexpr std::size_t state_count = 3;
+
+        int *column(std::size_t field)
+        {
+            return values_.data() + field * capacity_;
+        }
+        const int *column(std::size_t field) const
+        {
+            return values_.data() + field * capacity_;
+        }
+        void grow();
+
+        std::size_t field_count_;
+        std::size_t size_ = 0;
+        // Always a multiple of 64, padding models have power off
+        std::size_t capacity_ = 0;
+        std::vector<std::uint8_t> power_;
+        // Field major: field f of model m is values_[f * capacity_ + m]
+        std::vector<int> values_;
+    };
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include <vector>
+#include "cells.h"
+
+namespace cells
+{
+    /// @brief Where a beam starts and the direction it is heading
+    struct Entry
+    {
+        XY location;
+        Direction direction;
+
+        bool operator==(const Entry &other) const = default;
+    };
+
+    /// @brief Every entry from outside the grid: each top cell heading Down,
+    /// bottom cell heading Up, left cell heading Right and right cell heading Left
+    std::vector<Entry> edge_entries(Coord width, Coord height);
+
+    /// @brief Entries traced together by trace_entries, 256 when built with AVX2
+#if defined(__AVX2__)
+    constexpr std::size_t default_trace_lanes = 256;
+#else
+    constexpr std::size_t default_trace_lanes = 64;
+#endif
+
+    /// @brief trace_grid for many entries at once, result[i] is the energized
+    /// count for entries[i].
+    ///
+    /// Entries are traced in passes of `lanes` (64 or 256) queries.  Every
+    /// (cell, direction) keeps a bitmask of the queries that reached it, and
+    /// masks are carried along straight runs by sweeping the grid in each
+    /// direction until nothing new arrives, so one walk over the grid serves
+    /// every query in the pass.  Per query counts come from a bit sliced
+    /// counter over the per-cell masks.
+    std::vector<std::size_t> trace_entries(const Grid &grid, std::span<const Entry> entries, std::size_t lanes = default_trace_lanes);
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "state_machine.h"
+
+namespace state_machine
+{
+    using ChannelId = std::size_t;
+
+    struct OutputWrite
+    {
+        ChannelId channel;
+        OnOff value;
+
+        bool operator==(const OutputWrite &other) const = default;
+    };
+
+    /// @brief Destination for output writes.  Each call is one bus transaction.
+    class IOutputBus
+    {
+    public:
+        virtual ~IOutputBus() = default;
+        virtual void write(const OutputWrite *writes, std::size_t count) = 0;
+    };
+
+    /// @brief Local stand-in for a slow output bus.  Every transaction costs a
+    /// fixed overhead plus a per-write cost, spent busy-waiting.
+    class SimulatedBus : public IOutputBus
+    {
+    public:
+        SimulatedBus(double transaction_seconds = 0.0, double write_seconds = 0.0)
+            : transaction_seconds(transaction_seconds), write_seconds(write_seconds) {}
+        void write(const OutputWrite *writes, std::size_t count) override;
+
+        /// @brief Last value written to each channel
+        std::vector<OnOff> values;
+        std::size_t transactions = 0;
+        std::size_t writes = 0;
+
+    private:
+        double transaction_seconds;
+        double write_seconds;
+    };
+
+    /// @brief Collects output changes during a frame and sends them to the bus in a
+    /// single transaction on flush.  Writes that leave a channel at the value the bus
+    /// already has are dropped.
+    class OutputBuffer
+    {
+    public:
+        OutputBuffer(IOutputBus &bus) : bus(bus) {}
+
+        /// @brief Add a channel, assumed to start Off on the bus
+        ChannelId add_channel();
+        void set(ChannelId channel, OnOff value);
+        /// @brief Value the channel will have after the next flush
+        OnOff pending(ChannelId channel) const
+        {
+            return channels_[channel].pending;
+        }
+        /// @brief Send every changed channel to the bus in one transaction
+        /// @return number of channels written
+        std::size_t flush();
+
+    private:
+        struct Channel
+        {
+            OnOff committed = OnOff::Off;
+            OnOff pending = OnOff::Off;
+            bool dirty = false;
+        };
+
+        IOutputBus &bus;
+        std::vector<Channel> channels_;
+        std::vector<ChannelId> dirty_;
+        // Reused between flushes so steady state frames do not allocate
+        std::vector<OutputWrite> writes_;
+    };
+
+    /// @brief IIO that reads the button from another IIO and sends the light to an OutputBuffer channel.
+    class BufferedLightIO : public IIO
+    {
+    public:
+        BufferedLightIO(IIO &input, OutputBuffer &buffer)
+            : input(input), buffer(buffer), channel_(buffer.add_channel()) {}
+
+        void set_light(OnOff on_or_off) override
+        {
+            buffer.set(channel_, on_or_off);
+        }
+        bool button_pressed() override
+        {
+            return input.button_pressed();
+        }
+        bool button_released() override
+        {
+            return input.button_released();
+        }
+        ChannelId channel() const
+        {
+            return channel_;
+        }
+
+    private:
+        IIO &input;
+        OutputBuffer &buffer;
+        ChannelId channel_;
+    };
+}
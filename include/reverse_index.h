@@ -0,0 +1,81 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "multi_trace.h"
+
+namespace cells
+{
+    /// @brief One bit per edge entry, in edge_entries() order
+    class EntryBitmap
+    {
+    public:
+        explicit EntryBitmap(std::size_t size) : size_(size), words_((size + 63) / 64, 0) {}
+
+        void set(std::size_t index)
+        {
+            words_[index / 64] |= std::uint64_t(1) << (index % 64);
+        }
+        bool test(std::size_t index) const
+        {
+            return (words_[index / 64] >> (index % 64)) & 1;
+        }
+        std::size_t count() const
+        {
+            std::size_t total = 0;
+            for (auto word : words_)
+            {
+                total += static_cast<std::size_t>(std::popcount(word));
+            }
+            return total;
+        }
+        std::size_t size() const
+        {
+            return size_;
+        }
+        const std::vector<std::uint64_t> &words() const
+        {
+            return words_;
+        }
+
+    private:
+        std::size_t size_;
+        std::vector<std::uint64_t> words_;
+    };
+
+    /// @brief Answers "which edge entries energize cell (x, y)?" without
+    /// tracing every entry.
+    ///
+    /// Beams are followed backwards: a beam entering a cell in direction d came
+    /// from the neighbour behind it, entering that neighbour in any direction
+    /// next_directions turns into d.  A query walks that inverted graph from
+    /// the four (cell, direction) states of the target and collects the edge
+    /// entries it reaches.  Building is a linear pass that records which state
+    /// each edge entry starts in.
+    class ReverseBeamIndex
+    {
+    public:
+        explicit ReverseBeamIndex(const Grid &grid);
+
+        const std::vector<Entry> &entries() const
+        {
+            return entries_;
+        }
+        /// @brief Edge entries whose trace energizes (x, y), empty off the grid
+        EntryBitmap entries_reaching(Coord x, Coord y) const;
+
+    private:
+        static constexpr std::uint32_t no_entry = UINT32_MAX;
+
+        Coord width_;
+        Coord height_;
+        std::vector<Cell> cells_;
+        std::vector<Entry> entries_;
+        // Edge entries starting in state cell * 4 + direction, a corner starts two
+        std::vector<std::uint32_t> entry_of_state_;
+        // Entry directions of a cell that leave it in a given direction, by [cell][exit]
+        std::array<std::array<std::vector<Direction>, 4>, 5> entering_;
+    };
+}
@@ -0,0 +1,228 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <vector>
+#include "state_machine.h"
+
+namespace state_machine
+{
+    /// @brief Simulated time source.  Time only moves when the owner advances it.
+    class VirtualClock
+    {
+    public:
+        double now() const
+        {
+            return now_;
+        }
+        void advance_to(double time)
+        {
+            if (time > now_)
+            {
+                now_ = time;
+            }
+        }
+
+    private:
+        double now_ = 0.0;
+    };
+
+    /// @brief Timer whose expiration is measured against a VirtualClock.
+    class SimTimer : public ITimer
+    {
+    public:
+        SimTimer(const VirtualClock &clock) : clock(clock) {}
+        ITimer &reset(double seconds) override
+        {
+            deadline_ = clock.now() + seconds;
+            generation_++;
+            return *this;
+        }
+        bool expired() const override
+        {
+            return clock.now() >= deadline_;
+        }
+        /// @brief Time at which this timer expires, infinity if never reset
+        double deadline() const
+        {
+            return deadline_;
+        }
+        /// @brief Incremented on every reset so stale wakeups can be discarded
+        std::uint64_t generation() const
+        {
+            return generation_;
+        }
+
+    private:
+        const VirtualClock &clock;
+        double deadline_ = std::numeric_limits<double>::infinity();
+        std::uint64_t generation_ = 0;
+    };
+
+    /// @brief A change of the light output at a point in simulated time.
+    struct LightSample
+    {
+        double time;
+        OnOff value;
+
+        bool operator==(const LightSample &other) const = default;
+    };
+
+    /// @brief IO whose button is driven by the simulation and whose light
+    /// changes are recorded as a trace.  Redundant writes are not recorded.
+    class SimIO : public IIO
+    {
+    public:
+        SimIO(const VirtualClock &clock) : clock(clock) {}
+        void set_light(OnOff on_or_off) override
+        {
+            if (on_or_off != light_value)
+            {
+                light_value = on_or_off;
+                trace.push_back({clock.now(), on_or_off});
+            }
+        }
+        bool button_pressed() override
+        {
+            return button_pressed_value;
+        }
+        bool button_released() override
+        {
+            return !button_pressed_value;
+        }
+
+        OnOff light_value = OnOff::Off;
+        bool button_pressed_value = false;
+        std::vector<LightSample> trace;
+
+    private:
+        const VirtualClock &clock;
+    };
+
+    /// @brief Discrete-event driver for many independent behaviors.
+    ///
+    /// Rather than stepping in fixed frames, time jumps directly to the next
+    /// timer deadline or scheduled button change, and only the instance that
+    /// owns that event is run.  Behavior must be constructible from (IIO &, ITimer &)
+    /// and expose do_work().
+    template <typename Behavior = PolledButtonBehavior>
+    class Simulation
+    {
+    public:
+        struct Instance
+        {
+            Instance(const VirtualClock &clock) : io(clock), timer(clock), behavior(io, timer) {}
+
+            SimIO io;
+            SimTimer timer;
+            Behavior behavior;
+        };
+
+        /// @brief Create a new instance and give it its first frame at the current time
+        std::size_t add_instance()
+        {
+            auto index = instances_.size();
+            instances_.emplace_back(clock_);
+            step(index);
+            return index;
+        }
+
+        /// @brief Set the button of an instance to pressed or released at the given time
+        void schedule_button(std::size_t index, double time, bool pressed)
+        {
+            events_.push({time, sequence_++, index, pressed ? Kind::Press : Kind::Release, 0});
+        }
+
+        /// @brief Process every event up to and including end_time, then leave the clock at end_time
+        void run_until(double end_time)
+        {
+            while (!events_.empty() && events_.top().time <= end_time)
+            {
+                auto event = events_.top();
+                events_.pop();
+
+                auto &instance = instances_[event.instance];
+                if (event.kind == Kind::Timer && event.generation != instance.timer.generation())
+                {
+                    // The timer was reset after this wakeup was scheduled
+                    continue;
+                }
+                clock_.advance_to(event.time);
+                if (event.kind != Kind::Timer)
+                {
+                    instance.io.button_pressed_value = event.kind == Kind::Press;
+                }
+                step(event.instance);
+            }
+            clock_.advance_to(end_time);
+        }
+
+        double now() const
+        {
+            return clock_.now();
+        }
+        std::size_t size() const
+        {
+            return instances_.size();
+        }
+        Instance &operator[](std::size_t index)
+        {
+            return instances_[index];
+        }
+        /// @brief Number of events that resulted in a behavior being run
+        std::size_t steps() const
+        {
+            return steps_;
+        }
+
+    private:
+        enum class Kind
+        {
+            Timer,
+            Press,
+            Release
+        };
+        struct Event
+        {
+            double time;
+            std::uint64_t sequence;
+            std::size_t instance;
+            Kind kind;
+            std::uint64_t generation;
+
+            // Ordered so the priority queue yields the earliest event, ties in scheduling order
+            bool operator>(const Event &other) const
+            {
+                if (time != other.time)
+                {
+                    return time > other.time;
+                }
+                return sequence > other.sequence;
+            }
+        };
+
+        void step(std::size_t index)
+        {
+            auto &instance = instances_[index];
+            auto previous_generation = instance.timer.generation();
+            instance.behavior.do_work();
+            steps_++;
+            // Only schedule a wakeup if the behavior armed the timer during this step
+            if (instance.timer.generation() != previous_generation &&
+                instance.timer.deadline() != std::numeric_limits<double>::infinity())
+            {
+                events_.push({instance.timer.deadline(), sequence_++, index, Kind::Timer, instance.timer.generation()});
+            }
+        }
+
+        VirtualClock clock_;
+        // deque keeps instance addresses stable, behaviors hold references to their io and timer
+        std::deque<Instance> instances_;
+        std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events_;
+        std::uint64_t sequence_ = 0;
+        std::size_t steps_ = 0;
+    };
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstddef>
+#include <optional>
+#include <tuple>
+#include <vector>
+#include "cells.h"
+
+namespace cells
+{
+    /// @brief Grid storing only the non-space cells, for grids that are mostly Cell::Space.
+    ///
+    /// Obstacles are kept in row-major order with per-row offsets (CSR), and
+    /// again as a column-major index with per-column offsets, so both at() and
+    /// "next obstacle in a direction" are a binary search within one row or column.
+    /// Memory is O(width + height + obstacles) instead of O(width * height).
+    class SparseGrid
+    {
+    public:
+        struct Obstacle
+        {
+            Coord x;
+            Coord y;
+            Cell cell;
+        };
+
+        SparseGrid(Coord width, Coord height, std::vector<Obstacle> obstacles);
+        explicit SparseGrid(const Grid &grid);
+
+        std::optional<Cell> at(Coord x, Coord y) const;
+        Coord width() const
+        {
+            return width_;
+        }
+        Coord height() const
+        {
+            return height_;
+        }
+        std::size_t obstacle_count() const
+        {
+            return obstacles_.size();
+        }
+        const Obstacle &obstacle(std::size_t id) const
+        {
+            return obstacles_[id];
+        }
+
+        /// @brief First obstacle at or beyond location when moving in direction
+        /// @return index usable with obstacle(), or nullopt if the beam leaves the grid
+        std::optional<std::size_t> next_obstacle(const XY &location, const Direction &direction) const;
+
+    private:
+        Coord width_;
+        Coord height_;
+        // Sorted by (y, x), row y is obstacles_[row_offsets_[y] .. row_offsets_[y + 1])
+        std::vector<Obstacle> obstacles_;
+        std::vector<std::size_t> row_offsets_;
+        // Obstacle indices sorted by (x, y), column x is [column_offsets_[x] .. column_offsets_[x + 1])
+        std::vector<std::size_t> column_entries_;
+        std::vector<std::size_t> column_offsets_;
+    };
+
+    /// @brief Same result as trace_grid on the equivalent dense Grid.
+    /// Beams jump from obstacle to obstacle and the energized cells are counted
+    /// from the straight segments between them, so the cost depends on the
+    /// number of obstacles reached rather than the grid area.
+    std::size_t trace_grid(const SparseGrid &grid, const XY &entry_location, const Direction &entry_direction);
+}
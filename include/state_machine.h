@@ -0,0 +1,153 @@
+#pragma once
+#include <cstddef>
+
+namespace state_machine
+{
+    enum class FlashResult
+    {
+        Released,
+        Timer
+    };
+
+    enum class OnOff
+    {
+        On,
+        Off
+    };
+    OnOff toggle(OnOff value);
+
+    class IIO
+    {
+    public:
+        virtual ~IIO() = default;
+        virtual void set_light(OnOff on_or_off) = 0;
+        virtual bool button_pressed() = 0;
+        virtual bool button_released() = 0;
+    };
+
+    class ITimer
+    {
+    public:
+        virtual ~ITimer() = default;
+        virtual ITimer &reset(double seconds) = 0;
+        virtual bool expired() const = 0;
+    };
+
+    /// Busy-waits on the two options.  Returns RELEASED if button released, ITimer if ITimer expired
+    FlashResult button_released_or_timer_expired(IIO &io, ITimer &timer);
+    /// @brief Blocking style: blink the light until the button is released, then turn it off
+    void flash_until_button_released(IIO &io, ITimer &timer);
+    void wait_until_button_pressed(IIO &io);
+    /// @brief Blocking style entry point.  Never returns.
+    void start(IIO &io, ITimer &timer);
+
+    enum class ButtonStates
+    {
+        NotPressed,
+        BlinkOn,
+        BlinkOff,
+        ReleasedButton
+    };
+    constexpr std::size_t button_state_count = 4;
+
+    /// @brief Default transition observer, compiles away to nothing.
+    struct NullTransitionObserver
+    {
+        void on_transition(ButtonStates, ButtonStates) {}
+    };
+
+    /// @brief Frame based (polled) version of the blinking light behavior.
+    /// Each call to do_work runs as many transitions as the current inputs allow.
+    /// Observer::on_transition(from, to) is called on every state change.
+    template <typename Observer = NullTransitionObserver>
+    class BasicPolledButtonBehavior
+    {
+    public:
+        using States = ButtonStates;
+
+        BasicPolledButtonBehavior(IIO &io, ITimer &timer, Observer observer = {})
+            : io(io), timer(timer), observer(observer) {}
+        void do_work()
+        {
+            // handle_state might perform multiple state transitions, so call
+            // it repeatedly until it's done working.
+            while (handle_state() == true)
+            {
+            }
+        }
+
+        // Return false when there is no more work to do
+        bool handle_state()
+        {
+            switch (current_state)
+            {
+            case States::NotPressed:
+                if (io.button_pressed())
+                {
+                    transition_to(States::BlinkOn);
+                    io.set_light(OnOff::On);
+                    timer.reset(1.0);
+                    return true;
+                }
+                break;
+            case States::BlinkOn:
+                if (io.button_released())
+                {
+                    transition_to(States::ReleasedButton);
+                    return true;
+                }
+                if (timer.expired())
+                {
+                    io.set_light(OnOff::Off);
+                    timer.reset(1.0);
+                    transition_to(States::BlinkOff);
+                    return true;
+                }
+                break;
+            case States::BlinkOff:
+                if (io.button_released())
+                {
+                    transition_to(States::ReleasedButton);
+                    return true;
+                }
+                if (timer.expired())
+                {
+                    io.set_light(OnOff::On);
+                    timer.reset(1.0);
+                    transition_to(States::BlinkOn);
+                    return true;
+                }
+                break;
+            case States::ReleasedButton:
+                io.set_light(OnOff::Off);
+                transition_to(States::NotPressed);
+                return true;
+                break;
+            }
+            return false;
+        }
+
+        States get_state() const
+        {
+            return current_state;
+        }
+        Observer &get_observer()
+        {
+            return observer;
+        }
+
+    protected:
+        void transition_to(States next)
+        {
+            observer.on_transition(current_state, next);
+            current_state = next;
+        }
+
+        States current_state = States::NotPressed;
+        IIO &io;
+        ITimer &timer;
+        [[no_unique_address]] Observer observer;
+    };
+
+    using PolledButtonBehavior = BasicPolledButtonBehavior<>;
+}
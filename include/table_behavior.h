@@ -0,0 +1,64 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include "state_machine.h"
+
+namespace state_machine
+{
+    /// @brief Table driven version of PolledButtonBehavior.
+    /// The transition logic lives in a static table of (from, guard, action, to)
+    /// rows instead of a switch.  Rows for a state are checked in order.
+    class TableButtonBehavior
+    {
+    public:
+        using States = PolledButtonBehavior::States;
+
+        enum class Guard
+        {
+            Always,
+            ButtonPressed,
+            ButtonReleased,
+            TimerExpired
+        };
+        enum class Action
+        {
+            None,
+            LightOnResetTimer,
+            LightOffResetTimer,
+            LightOff
+        };
+        struct Transition
+        {
+            States from;
+            Guard guard;
+            Action action;
+            States to;
+        };
+
+        static const std::array<Transition, 6> table;
+
+        TableButtonBehavior(IIO &io, ITimer &timer) : io(io), timer(timer) {}
+        void do_work()
+        {
+            while (handle_state() == true)
+            {
+            }
+        }
+
+        // Return false when there is no more work to do
+        bool handle_state();
+
+        States get_state() const
+        {
+            return current_state;
+        }
+
+    protected:
+        bool check(Guard guard);
+        void perform(Action action);
+
+        States current_state = States::NotPressed;
+        IIO &io;
+        ITimer &timer;
+    };
+}
@@ -0,0 +1,177 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "beam_graph.h"
+#include "multi_trace.h"
+
+namespace cells
+{
+    /// @brief Binary protocol spoken by the trace daemon.
+    ///
+    /// Every message is a 9 byte header followed by `length` payload bytes, all
+    /// integers in host byte order since the socket never leaves the machine.
+    /// Requests carry an op, responses a status, and both echo the caller's
+    /// tag.  Responses come back in request order, so a client may pipeline as
+    /// many requests as it likes before reading.
+    namespace trace_protocol
+    {
+        enum class Op : std::uint8_t
+        {
+            /// Payload is grid text, one row per line.  Responds with a u32 grid handle.
+            Load = 1,
+            /// Payload is a u32 grid handle then any number of entries, each
+            /// i64 x, i64 y, u8 direction.  Responds with a u64 count per entry.
+            Trace = 2,
+            /// Payload is a u32 grid handle.  Responds with nothing.
+            Unload = 3,
+        };
+
+        enum class Status : std::uint8_t
+        {
+            Ok = 0,
+            /// Payload is the error message
+            Error = 1,
+        };
+
+        constexpr std::size_t header_size = 9;
+        constexpr std::size_t entry_size = 17;
+        /// Larger frames are treated as a corrupt stream
+        constexpr std::uint32_t max_payload = 64 * 1024 * 1024;
+
+        /// @brief Append a header for payload_length bytes, op or status in code
+        void put_header(std::vector<std::uint8_t> &out, std::uint32_t payload_length, std::uint8_t code, std::uint32_t tag);
+        /// @brief Append a complete Trace request
+        void put_trace(std::vector<std::uint8_t> &out, std::uint32_t tag, std::uint32_t grid, std::span<const Entry> entries);
+    }
+
+    /// @brief Grids kept resident with their BeamGraph, answering protocol requests.
+    ///
+    /// Independent of any socket so the same service can sit behind the
+    /// daemon, a test or a benchmark.
+    class TraceService
+    {
+    public:
+        /// Cells a Load may bring in unless told otherwise, a 2048 x 2048 grid
+        static constexpr std::size_t default_max_cells = std::size_t(1) << 22;
+
+        /// @brief Loads of more than max_cells cells, or that would take the
+        /// resident grids and graphs past memory_budget bytes, are answered
+        /// with an error.  Graphs are built on the caller's thread, so this
+        /// also bounds how long one Load can hold up every other request.
+        explicit TraceService(std::size_t max_cells = default_max_cells, std::size_t memory_budget = BeamGraph::default_memory_budget)
+            : max_cells_(max_cells), memory_budget_(memory_budget) {}
+
+        /// @brief Answer every complete request at the front of input, appending
+        /// the responses to output.  Returns the bytes consumed, leaving any
+        /// partial request for the next call.  Throws on a corrupt stream.
+        std::size_t handle(std::span<const std::uint8_t> input, std::vector<std::uint8_t> &output);
+
+        std::size_t grid_count() const
+        {
+            return grids_.size();
+        }
+        /// @brief Bytes held by the resident grids and their graphs
+        std::size_t memory_bytes() const
+        {
+            return memory_used_;
+        }
+
+    private:
+        struct Resident
+        {
+            Resident(Grid grid, std::size_t graph_budget) : grid(std::move(grid)), graph(this->grid, graph_budget) {}
+            Grid grid;
+            BeamGraph graph;
+            std::size_t bytes = 0;
+        };
+
+        void respond(std::uint8_t op, std::uint32_t tag, std::span<const std::uint8_t> payload, std::vector<std::uint8_t> &output);
+        const Resident &resident(std::uint32_t handle) const;
+
+        std::unordered_map<std::uint32_t, std::unique_ptr<Resident>> grids_;
+        std::uint32_t next_handle_ = 1;
+        std::size_t max_cells_;
+        std::size_t memory_budget_;
+        std::size_t memory_used_ = 0;
+    };
+
+    /// @brief Long lived daemon answering TraceService requests on a Unix socket.
+    ///
+    /// One thread polls every client.  Sockets are non-blocking; each wakeup
+    /// reads what has arrived, answers every complete request in it and
+    /// writes the responses back in as few writes as the socket allows.  A
+    /// client whose responses pile up is not read again until it drains them.
+    class TraceServer
+    {
+    public:
+        /// @brief Bind and listen on socket_path, replacing a stale socket file
+        explicit TraceServer(const std::string &socket_path);
+        TraceServer(const TraceServer &) = delete;
+        TraceServer &operator=(const TraceServer &) = delete;
+        ~TraceServer();
+
+        /// @brief Serve until stop() is called
+        void run();
+        /// @brief Make run() return, safe from any thread
+        void stop();
+
+        TraceService &service()
+        {
+            return service_;
+        }
+
+    private:
+        struct Client
+        {
+            int fd;
+            std::vector<std::uint8_t> in;
+            std::vector<std::uint8_t> out;
+            std::size_t written = 0;
+        };
+
+        /// @brief Read, answer and write for one client, false once it is gone
+        bool serve(Client &client, short events);
+
+        std::string path_;
+        int listen_fd_ = -1;
+        int wake_[2] = {-1, -1};
+        std::atomic<bool> stopping_{false};
+        TraceService service_;
+        std::vector<Client> clients_;
+    };
+
+    /// @brief Blocking client for TraceServer
+    class TraceClient
+    {
+    public:
+        explicit TraceClient(const std::string &socket_path);
+        TraceClient(const TraceClient &) = delete;
+        TraceClient &operator=(const TraceClient &) = delete;
+        ~TraceClient();
+
+        /// @brief Load grid text, returning its handle
+        std::uint32_t load(const std::string &grid_text);
+        /// @brief trace_grid for each entry, in one request
+        std::vector<std::uint64_t> trace(std::uint32_t grid, std::span<const Entry> entries);
+        void unload(std::uint32_t grid);
+
+        /// @brief Send a Trace request without waiting, returning its tag
+        std::uint32_t send_trace(std::uint32_t grid, std::span<const Entry> entries);
+        /// @brief Counts for the oldest unanswered request, which must be tag
+        std::vector<std::uint64_t> receive_trace(std::uint32_t tag);
+
+    private:
+        std::vector<std::uint8_t> call(trace_protocol::Op op, std::span<const std::uint8_t> payload);
+        std::vector<std::uint8_t> receive(std::uint32_t tag);
+        void send(const std::vector<std::uint8_t> &bytes);
+
+        int fd_ = -1;
+        std::uint32_t next_tag_ = 1;
+    };
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "cells.h"
+
+namespace cells
+{
+    struct TraceTimeline
+    {
+        /// Same as trace_grid
+        std::size_t energized = 0;
+        /// Cells first energized at each step, step 0 being the entry cell.
+        /// A cell's step is the shortest beam distance from the entry to it.
+        std::vector<std::uint32_t> new_cells;
+    };
+
+    /// @brief trace_grid that also records when each cell lights up.
+    ///
+    /// Beams advance one cell per step as a breadth first front, so the first
+    /// time a cell is reached is its distance from the entry.  Visited
+    /// directions are kept as one byte per cell, four bits used, in one
+    /// flat array.
+    TraceTimeline trace_timeline(const Grid &grid, const XY &entry_location, const Direction &entry_direction);
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include "state_machine.h"
+
+namespace state_machine
+{
+    /// @brief Transition counts and dwell time histograms shared by many behaviors.
+    ///
+    /// Writers increment counters in a shard picked by their thread, so threads
+    /// normally never touch the same cache line.  Counters are relaxed atomics, so
+    /// recording is lock-free even when more threads than shards share one.
+    /// Reads sum over every shard.
+    class TransitionMetrics
+    {
+    public:
+        /// Bucket 0 is under 1us, bucket k holds dwell times in [2^(k-1), 2^k) us
+        static constexpr std::size_t histogram_buckets = 40;
+        static constexpr std::size_t shard_count = 16;
+
+        using Histogram = std::array<std::uint64_t, histogram_buckets>;
+
+        /// @brief Record leaving from after dwell_seconds and entering to
+        void record(ButtonStates from, ButtonStates to, double dwell_seconds);
+
+        std::uint64_t transition_count(ButtonStates from, ButtonStates to) const;
+        /// @brief Number of completed visits to a state
+        std::uint64_t dwell_count(ButtonStates state) const;
+        double total_dwell_seconds(ButtonStates state) const;
+        Histogram dwell_histogram(ButtonStates state) const;
+
+        static std::size_t bucket_for(double dwell_seconds);
+
+    private:
+        struct alignas(64) Shard
+        {
+            std::array<std::atomic<std::uint64_t>, button_state_count * button_state_count> transitions{};
+            std::array<std::atomic<std::uint64_t>, button_state_count> dwell_nanoseconds{};
+            std::array<std::array<std::atomic<std::uint64_t>, histogram_buckets>, button_state_count> histograms{};
+        };
+
+        Shard &local_shard();
+
+        std::array<Shard, shard_count> shards_;
+    };
+
+    /// @brief Observer for BasicPolledButtonBehavior that feeds a TransitionMetrics.
+    /// Time comes from the now function, which defaults to the steady clock in seconds.
+    class MetricsObserver
+    {
+    public:
+        MetricsObserver(TransitionMetrics &metrics, std::function<double()> now = steady_seconds)
+            : metrics(&metrics), now(std::move(now)), entered_at(this->now()) {}
+
+        void on_transition(ButtonStates from, ButtonStates to)
+        {
+            auto time = now();
+            metrics->record(from, to, time - entered_at);
+            entered_at = time;
+        }
+
+        static double steady_seconds();
+
+    private:
+        TransitionMetrics *metrics;
+        std::function<double()> now;
+        double entered_at;
+    };
+}
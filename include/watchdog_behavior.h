@@ -0,0 +1,64 @@
+#pragma once
+#include "combinators.h"
+#include "frame_task.h"
+#include "state_machine.h"
+
+namespace state_machine
+{
+    /// @brief Voltage reading on the light output, used to check the light really switched.
+    class ILightFeedback
+    {
+    public:
+        virtual ~ILightFeedback() = default;
+        virtual bool light_voltage() = 0;
+    };
+
+    /// @brief Wait up to timeout_seconds for the light voltage to reach expected_reading,
+    /// then keep watching that it stays there.
+    ///
+    /// The "good condition" is that this never finishes.  Finishing means one of
+    /// the conditions failed, and failure is set to a description of which one.
+    FrameTask monitor_voltage_transition(ILightFeedback &feedback, ITimer &transition_timer,
+                                         bool expected_reading, double timeout_seconds, const char *&failure);
+
+    /// @brief Coroutine blinking light behavior with a watchdog on the light voltage.
+    /// While flashing, the button, the blink timer and monitor_voltage_transition
+    /// race each other.  A monitor failure stops the behavior and is reported by error().
+    class WatchdogButtonBehavior
+    {
+    public:
+        using States = ButtonStates;
+        static constexpr double transition_seconds = 0.1;
+
+        WatchdogButtonBehavior(IIO &io, ILightFeedback &feedback, ITimer &timer, ITimer &transition_timer)
+            : io(io), feedback(feedback), timer(timer), transition_timer(transition_timer), task(run()) {}
+        WatchdogButtonBehavior(const WatchdogButtonBehavior &) = delete;
+        WatchdogButtonBehavior &operator=(const WatchdogButtonBehavior &) = delete;
+
+        void do_work()
+        {
+            task.resume();
+        }
+        States get_state() const
+        {
+            return current_state;
+        }
+        /// @brief Description of the monitor failure, nullptr while healthy
+        const char *error() const
+        {
+            return error_;
+        }
+
+    protected:
+        FrameTask run();
+        FrameTask flash_until_button_released();
+
+        States current_state = States::NotPressed;
+        const char *error_ = nullptr;
+        IIO &io;
+        ILightFeedback &feedback;
+        ITimer &timer;
+        ITimer &transition_timer;
+        FrameTask task;
+    };
+}
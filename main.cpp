@@ -5,6 +5,9 @@
 #include <ranges>
 #include "lib.h"
 #include "cells.h"
+#include "trace_daemon.h"
+#include <csignal>
+#include <cstring>
 
 auto file_lines(const char *filename) {
     std::ifstream file(filename);
@@ -39,8 +42,23 @@ auto problem_lines(const char *filename) {
     return split_lines(contents);
 }
 
-int main()
+static cells::TraceServer *serving = nullptr;
+
+int main(int argc, char **argv)
 {
+    // your_project --serve <socket>: keep grids resident and answer trace queries
+    if (argc == 3 && std::strcmp(argv[1], "--serve") == 0)
+    {
+        cells::TraceServer server(argv[2]);
+        serving = &server;
+        auto stop = [](int)
+        { serving->stop(); };
+        std::signal(SIGINT, stop);
+        std::signal(SIGTERM, stop);
+        server.run();
+        return 0;
+    }
+
     auto filename = "problem.txt";
     // std::ifstream file(filename);
     // // use ranges to split this into lines
@@ -0,0 +1,61 @@
+#include "batch_behavior.h"
+
+namespace state_machine
+{
+    std::size_t ButtonBehaviorBatch::add()
+    {
+        states_.push_back(static_cast<std::uint8_t>(States::NotPressed));
+        buttons_.push_back(false);
+        lights_.push_back(false);
+        deadlines_.push_back(0.0);
+        return states_.size() - 1;
+    }
+
+    std::size_t ButtonBehaviorBatch::step(double now)
+    {
+        const double period = 1.0;
+        std::size_t transitions = 0;
+        const auto count = size();
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            auto state = static_cast<States>(states_[i]);
+            const bool pressed = buttons_[i];
+            // Same transitions as PolledButtonBehavior::handle_state, looped until nothing fires
+            while (true)
+            {
+                if (state == States::NotPressed)
+                {
+                    if (!pressed)
+                    {
+                        break;
+                    }
+                    state = States::BlinkOn;
+                    lights_[i] = true;
+                    deadlines_[i] = now + period;
+                }
+                else if (state == States::ReleasedButton)
+                {
+                    state = States::NotPressed;
+                    lights_[i] = false;
+                }
+                else if (!pressed)
+                {
+                    state = States::ReleasedButton;
+                }
+                else if (now >= deadlines_[i])
+                {
+                    state = (state == States::BlinkOn) ? States::BlinkOff : States::BlinkOn;
+                    lights_[i] = state == States::BlinkOn;
+                    deadlines_[i] = now + period;
+                }
+                else
+                {
+                    break;
+                }
+                transitions++;
+            }
+            states_[i] = static_cast<std::uint8_t>(state);
+        }
+        return transitions;
+    }
+}
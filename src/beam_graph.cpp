@@ -0,0 +1,465 @@
+#include "beam_graph.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <stdexcept>
+#include "multi_trace.h"
+
+namespace cells
+{
+    namespace
+    {
+        /// Running total of what a graph build allocates, checked before each allocation
+        class MemoryBudget
+        {
+        public:
+            explicit MemoryBudget(std::size_t limit) : limit_(limit) {}
+
+            void charge(std::size_t count, std::size_t bytes_each)
+            {
+                if (count > (limit_ - used_) / bytes_each)
+                {
+                    throw std::runtime_error("beam graph over its memory budget");
+                }
+                used_ += count * bytes_each;
+            }
+
+        private:
+            std::size_t limit_;
+            std::size_t used_ = 0;
+        };
+
+        /// Directions a cell can send light in, one segment each
+        std::size_t segments_leaving(Cell cell)
+        {
+            if (cell == Cell::Space)
+            {
+                return 0;
+            }
+            unsigned directions = 0;
+            for (int entry = 0; entry < 4; ++entry)
+            {
+                const auto &next = exits(cell, static_cast<Direction>(entry));
+                for (std::size_t i = 0; i < next.count; ++i)
+                {
+                    directions |= 1u << static_cast<unsigned>(next.directions[i]);
+                }
+            }
+            return static_cast<std::size_t>(std::popcount(directions));
+        }
+    }
+
+    BeamGraph::BeamGraph(const Grid &grid, std::size_t memory_budget)
+        : width_(grid.width()), height_(grid.height()), words_(static_cast<std::size_t>(width_ * height_ + 63) / 64)
+    {
+        const auto size = static_cast<std::size_t>(width_ * height_);
+        if (size > no_node)
+        {
+            throw std::runtime_error("grid too large for a beam graph");
+        }
+        MemoryBudget budget(memory_budget);
+        // The flat grid and four node ids per cell, then a scratch bitset of cells
+        budget.charge(size, sizeof(Cell) + 4 * sizeof(std::uint32_t));
+        budget.charge(words_, sizeof(std::uint64_t));
+        cells_ = flatten(grid);
+
+        // A node for every direction a non-space cell can send light
+        struct Segment
+        {
+            Coord x;
+            Coord y;
+            Direction direction;
+        };
+        struct Frame
+        {
+            std::uint32_t node;
+            std::size_t next_edge;
+        };
+        std::array<std::size_t, 5> leaving;
+        for (std::size_t cell = 0; cell < leaving.size(); ++cell)
+        {
+            leaving[cell] = segments_leaving(static_cast<Cell>(cell));
+        }
+        std::size_t nodes = 0;
+        for (auto cell : cells_)
+        {
+            nodes += leaving[static_cast<std::size_t>(cell)];
+        }
+        if (nodes > no_node)
+        {
+            throw std::runtime_error("too many beam segments for 32 bit node ids");
+        }
+        // Per segment: itself, where it ends, its edges (at most two), the
+        // Tarjan state, and at most one component with two successors
+        budget.charge(nodes, sizeof(Segment) + sizeof(XY) + sizeof(std::size_t) + 2 * sizeof(std::uint32_t) +
+                                 5 * sizeof(std::uint32_t) + sizeof(Frame) + 1 +
+                                 2 * sizeof(std::size_t) + 3 * sizeof(std::uint32_t));
+
+        std::vector<Segment> segments;
+        segments.reserve(nodes);
+        node_of_.assign(size * 4, no_node);
+        for (Coord y = 0; y < height_; ++y)
+        {
+            for (Coord x = 0; x < width_; ++x)
+            {
+                auto cell = cells_[cell_index(x, y)];
+                if (cell == Cell::Space)
+                {
+                    continue;
+                }
+                for (int entry = 0; entry < 4; ++entry)
+                {
+                    const auto &next = exits(cell, static_cast<Direction>(entry));
+                    for (std::size_t i = 0; i < next.count; ++i)
+                    {
+                        auto &node = node_of_[cell_index(x, y) * 4 + static_cast<std::size_t>(next.directions[i])];
+                        if (node == no_node)
+                        {
+                            node = static_cast<std::uint32_t>(segments.size());
+                            segments.push_back({x, y, next.directions[i]});
+                        }
+                    }
+                }
+            }
+        }
+
+        // Walk each segment to the next non-space cell, recording the nodes it leads to
+        std::vector<std::size_t> edge_offsets(nodes + 1, 0);
+        std::vector<std::uint32_t> edges;
+        edges.reserve(nodes * 2);
+        std::vector<XY> ends(nodes);
+        std::size_t segment_cells = 0;
+        for (std::size_t node = 0; node < nodes; ++node)
+        {
+            auto [x, y, direction] = segments[node];
+            auto [dx, dy] = delta(direction);
+            Coord end_x = x;
+            Coord end_y = y;
+            segment_cells++;
+            for (x += dx, y += dy; x >= 0 && y >= 0 && x < width_ && y < height_; x += dx, y += dy)
+            {
+                end_x = x;
+                end_y = y;
+                segment_cells++;
+                auto cell = cells_[cell_index(x, y)];
+                if (cell != Cell::Space)
+                {
+                    const auto &next = exits(cell, direction);
+                    for (std::size_t i = 0; i < next.count; ++i)
+                    {
+                        edges.push_back(node_of_[cell_index(x, y) * 4 + static_cast<std::size_t>(next.directions[i])]);
+                    }
+                    break;
+                }
+            }
+            ends[node] = {end_x, end_y};
+            edge_offsets[node + 1] = edges.size();
+        }
+        // A component lists each of its cells once, never more than its segments cover
+        budget.charge(segment_cells, sizeof(std::uint32_t));
+        own_cells_.reserve(segment_cells);
+
+        // Iterative Tarjan.  Components come out sinks first, so every
+        // successor component is already numbered when a component is completed.
+        node_component_.assign(nodes, no_node);
+        std::vector<std::uint32_t> order(nodes, no_node);
+        std::vector<std::uint32_t> low(nodes, 0);
+        std::vector<std::uint32_t> stack;
+        std::vector<bool> on_stack(nodes, false);
+        std::vector<Frame> calls;
+        std::uint32_t counter = 0;
+        // Last component that listed each component as a successor
+        std::vector<std::uint32_t> listed_by(nodes, no_node);
+        std::vector<std::uint64_t> scratch(words_, 0);
+        own_offsets_.push_back(0);
+        successor_offsets_.push_back(0);
+
+        auto finish_component = [&](std::uint32_t root)
+        {
+            const auto component = static_cast<std::uint32_t>(component_count());
+            std::vector<std::uint32_t> members;
+            std::uint32_t member;
+            do
+            {
+                member = stack.back();
+                stack.pop_back();
+                on_stack[member] = false;
+                node_component_[member] = component;
+                members.push_back(member);
+            } while (member != root);
+
+            for (auto node : members)
+            {
+                // The segment's own cells, start and end inclusive
+                auto [x, y, direction] = segments[node];
+                auto [dx, dy] = delta(direction);
+                auto [end_x, end_y] = ends[node];
+                for (;; x += dx, y += dy)
+                {
+                    auto index = cell_index(x, y);
+                    auto &word = scratch[index / 64];
+                    const auto bit = std::uint64_t(1) << (index % 64);
+                    if (!(word & bit))
+                    {
+                        word |= bit;
+                        own_cells_.push_back(static_cast<std::uint32_t>(index));
+                    }
+                    if (x == end_x && y == end_y)
+                    {
+                        break;
+                    }
+                }
+                for (auto edge = edge_offsets[node]; edge < edge_offsets[node + 1]; ++edge)
+                {
+                    auto successor = node_component_[edges[edge]];
+                    if (successor != component && listed_by[successor] != component)
+                    {
+                        listed_by[successor] = component;
+                        successors_.push_back(successor);
+                    }
+                }
+            }
+            for (auto cell = own_offsets_.back(); cell < own_cells_.size(); ++cell)
+            {
+                scratch[own_cells_[cell] / 64] = 0;
+            }
+            own_offsets_.push_back(own_cells_.size());
+            successor_offsets_.push_back(successors_.size());
+        };
+
+        for (std::uint32_t start = 0; start < nodes; ++start)
+        {
+            if (order[start] != no_node)
+            {
+                continue;
+            }
+            calls.push_back({start, edge_offsets[start]});
+            order[start] = low[start] = counter++;
+            stack.push_back(start);
+            on_stack[start] = true;
+            while (!calls.empty())
+            {
+                auto &frame = calls.back();
+                const auto node = frame.node;
+                if (frame.next_edge < edge_offsets[node + 1])
+                {
+                    auto successor = edges[frame.next_edge++];
+                    if (order[successor] == no_node)
+                    {
+                        order[successor] = low[successor] = counter++;
+                        stack.push_back(successor);
+                        on_stack[successor] = true;
+                        calls.push_back({successor, edge_offsets[successor]});
+                    }
+                    else if (on_stack[successor])
+                    {
+                        low[node] = std::min(low[node], order[successor]);
+                    }
+                    continue;
+                }
+                if (low[node] == order[node])
+                {
+                    finish_component(node);
+                }
+                calls.pop_back();
+                if (!calls.empty())
+                {
+                    auto parent = calls.back().node;
+                    low[parent] = std::min(low[parent], low[node]);
+                }
+            }
+        }
+
+        // Store the cells energized from each component an edge entry leads
+        // to.  Sinks first, so each one reuses the sets stored below it.
+        std::vector<std::uint32_t> roots;
+        for (const auto &entry : edge_entries(width_, height_))
+        {
+            auto [x, y] = entry.location;
+            auto [dx, dy] = delta(entry.direction);
+            for (; x >= 0 && y >= 0 && x < width_ && y < height_; x += dx, y += dy)
+            {
+                auto index = cell_index(x, y);
+                if (cells_[index] == Cell::Space)
+                {
+                    continue;
+                }
+                const auto &next = exits(cells_[index], entry.direction);
+                for (std::size_t i = 0; i < next.count; ++i)
+                {
+                    roots.push_back(node_component_[node_of_[index * 4 + static_cast<std::size_t>(next.directions[i])]]);
+                }
+                break;
+            }
+        }
+        std::sort(roots.begin(), roots.end());
+        roots.erase(std::unique(roots.begin(), roots.end()), roots.end());
+        budget.charge(component_count(), sizeof(std::uint32_t));
+        reach_of_.assign(component_count(), no_node);
+        budget.charge(roots.size(), sizeof(Reach));
+        reaches_.reserve(roots.size());
+        for (auto root : roots)
+        {
+            std::fill(scratch.begin(), scratch.end(), 0);
+            Reach reach;
+            reach.size = energize(root, scratch);
+            // Whichever is smaller, a cell list or a bitset
+            if (reach.size * sizeof(std::uint32_t) < words_ * sizeof(std::uint64_t))
+            {
+                budget.charge(reach.size, sizeof(std::uint32_t));
+                reach.cells.reserve(reach.size);
+                for (std::size_t w = 0; w < words_; ++w)
+                {
+                    for (auto word = scratch[w]; word; word &= word - 1)
+                    {
+                        reach.cells.push_back(static_cast<std::uint32_t>(w * 64 + static_cast<std::size_t>(std::countr_zero(word))));
+                    }
+                }
+            }
+            else
+            {
+                budget.charge(words_, sizeof(std::uint64_t));
+                reach.bits = scratch;
+            }
+            reach_of_[root] = static_cast<std::uint32_t>(reaches_.size());
+            reaches_.push_back(std::move(reach));
+        }
+    }
+
+    std::size_t BeamGraph::memory_bytes() const
+    {
+        auto bytes = cells_.capacity() * sizeof(Cell) +
+                     (node_of_.capacity() + node_component_.capacity() + own_cells_.capacity() + successors_.capacity() + reach_of_.capacity()) * sizeof(std::uint32_t) +
+                     (own_offsets_.capacity() + successor_offsets_.capacity()) * sizeof(std::size_t) +
+                     reaches_.capacity() * sizeof(Reach);
+        for (const auto &reach : reaches_)
+        {
+            bytes += reach.cells.capacity() * sizeof(std::uint32_t) + reach.bits.capacity() * sizeof(std::uint64_t);
+        }
+        return bytes;
+    }
+
+    std::size_t BeamGraph::energize(std::uint32_t component, std::vector<std::uint64_t> &energized) const
+    {
+        std::size_t added = 0;
+        auto set = [&](std::size_t cell)
+        {
+            auto &word = energized[cell / 64];
+            const auto bit = std::uint64_t(1) << (cell % 64);
+            added += (word & bit) == 0;
+            word |= bit;
+        };
+        // Adds the stored set of a component, if it has one
+        auto add_stored = [&](std::uint32_t stored)
+        {
+            if (reach_of_[stored] == no_node)
+            {
+                return false;
+            }
+            const auto &reach = reaches_[reach_of_[stored]];
+            for (auto cell : reach.cells)
+            {
+                set(cell);
+            }
+            for (std::size_t w = 0; w < reach.bits.size(); ++w)
+            {
+                added += static_cast<std::size_t>(std::popcount(reach.bits[w] & ~energized[w]));
+                energized[w] |= reach.bits[w];
+            }
+            return true;
+        };
+        if (add_stored(component))
+        {
+            return added;
+        }
+
+        // Depth first over the DAG, not descending below stored sets
+        std::vector<bool> seen(component_count(), false);
+        std::vector<std::uint32_t> pending = {component};
+        seen[component] = true;
+        while (!pending.empty())
+        {
+            auto next = pending.back();
+            pending.pop_back();
+            if (next != component && add_stored(next))
+            {
+                continue;
+            }
+            for (auto cell = own_offsets_[next]; cell < own_offsets_[next + 1]; ++cell)
+            {
+                set(own_cells_[cell]);
+            }
+            for (auto edge = successor_offsets_[next]; edge < successor_offsets_[next + 1]; ++edge)
+            {
+                auto successor = successors_[edge];
+                if (!seen[successor])
+                {
+                    seen[successor] = true;
+                    pending.push_back(successor);
+                }
+            }
+        }
+        return added;
+    }
+
+    std::size_t BeamGraph::trace(const XY &entry_location, const Direction &entry_direction) const
+    {
+        auto [x, y] = entry_location;
+        auto [dx, dy] = delta(entry_direction);
+        std::vector<std::uint64_t> energized(words_, 0);
+        std::size_t count = 0;
+        for (; x >= 0 && y >= 0 && x < width_ && y < height_; x += dx, y += dy)
+        {
+            auto index = cell_index(x, y);
+            auto cell = cells_[index];
+            if (cell == Cell::Space)
+            {
+                energized[index / 64] |= std::uint64_t(1) << (index % 64);
+                count++;
+                continue;
+            }
+            const auto &next = exits(cell, entry_direction);
+            for (std::size_t i = 0; i < next.count; ++i)
+            {
+                count += energize(node_component_[node_of_[index * 4 + static_cast<std::size_t>(next.directions[i])]], energized);
+            }
+            return count;
+        }
+        // Straight through empty space and off the grid
+        return count;
+    }
+
+    std::size_t BeamGraph::upper_bound(const XY &entry_location, const Direction &entry_direction) const
+    {
+        auto [x, y] = entry_location;
+        auto [dx, dy] = delta(entry_direction);
+        std::size_t prefix = 0;
+        for (; x >= 0 && y >= 0 && x < width_ && y < height_; x += dx, y += dy)
+        {
+            auto index = cell_index(x, y);
+            auto cell = cells_[index];
+            if (cell == Cell::Space)
+            {
+                prefix++;
+                continue;
+            }
+            const auto &next = exits(cell, entry_direction);
+            for (std::size_t i = 0; i < next.count; ++i)
+            {
+                auto reach = reach_of_[node_component_[node_of_[index * 4 + static_cast<std::size_t>(next.directions[i])]]];
+                if (reach == no_node)
+                {
+                    return trace(entry_location, entry_direction);
+                }
+                prefix += reaches_[reach].size;
+            }
+            return prefix;
+        }
+        return prefix;
+    }
+
+    std::size_t trace_grid(const BeamGraph &graph, const XY &entry_location, const Direction &entry_direction)
+    {
+        return graph.trace(entry_location, entry_direction);
+    }
+}
@@ -0,0 +1,177 @@
+#include "bitboard_grid.h"
+#include <algorithm>
+#include <bit>
+
+namespace cells
+{
+    BitboardGrid::BitboardGrid(const Grid &grid)
+        : width_(grid.width()), height_(grid.height()), words_per_row_(static_cast<std::size_t>((width_ + 63) / 64))
+    {
+        const auto plane_size = static_cast<std::size_t>(height_) * words_per_row_;
+        for (auto &exits_by_entry : routes_)
+        {
+            for (auto &plane : exits_by_entry)
+            {
+                plane.assign(plane_size, 0);
+            }
+        }
+        for (Coord y = 0; y < height_; ++y)
+        {
+            for (Coord x = 0; x < width_; ++x)
+            {
+                auto word = static_cast<std::size_t>(y) * words_per_row_ + static_cast<std::size_t>(x / 64);
+                auto bit = std::uint64_t(1) << (x % 64);
+                for (std::size_t entry = 0; entry < 4; ++entry)
+                {
+                    const auto &next = exits(*grid.at(x, y), static_cast<Direction>(entry));
+                    for (std::size_t i = 0; i < next.count; ++i)
+                    {
+                        routes_[entry][static_cast<std::size_t>(next.directions[i])][word] |= bit;
+                    }
+                }
+            }
+        }
+        for (std::size_t entry = 0; entry < 4; ++entry)
+        {
+            for (std::size_t exit = 0; exit < 4; ++exit)
+            {
+                for (auto word : routes_[entry][exit])
+                {
+                    if (word)
+                    {
+                        route_pairs_.push_back({static_cast<Direction>(entry), static_cast<Direction>(exit)});
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    namespace
+    {
+        /// Move every bit of `from` one cell in direction, keep the ones not
+        /// yet visited in `to`, add them to visited.  Returns whether any were new.
+        bool advance(const BitboardGrid::Plane &from, BitboardGrid::Plane &to, BitboardGrid::Plane &visited,
+                     Direction direction, std::size_t words_per_row, std::uint64_t last_word_mask)
+        {
+            const auto rows = from.size() / words_per_row;
+            std::uint64_t any = 0;
+            auto keep = [&](std::size_t index, std::uint64_t moved)
+            {
+                moved &= ~visited[index];
+                visited[index] |= moved;
+                to[index] = moved;
+                any |= moved;
+            };
+            switch (direction)
+            {
+            case Direction::Right:
+                for (std::size_t row = 0; row < rows; ++row)
+                {
+                    const auto base = row * words_per_row;
+                    std::uint64_t carry = 0;
+                    for (std::size_t w = 0; w < words_per_row; ++w)
+                    {
+                        auto word = from[base + w];
+                        auto moved = (word << 1) | carry;
+                        carry = word >> 63;
+                        keep(base + w, w + 1 == words_per_row ? moved & last_word_mask : moved);
+                    }
+                }
+                break;
+            case Direction::Left:
+                for (std::size_t row = 0; row < rows; ++row)
+                {
+                    const auto base = row * words_per_row;
+                    std::uint64_t carry = 0;
+                    for (std::size_t w = words_per_row; w-- > 0;)
+                    {
+                        auto word = from[base + w];
+                        keep(base + w, (word >> 1) | carry);
+                        carry = word << 63;
+                    }
+                }
+                break;
+            case Direction::Down:
+                for (std::size_t w = 0; w < words_per_row; ++w)
+                {
+                    to[w] = 0;
+                }
+                for (std::size_t index = words_per_row; index < from.size(); ++index)
+                {
+                    keep(index, from[index - words_per_row]);
+                }
+                break;
+            case Direction::Up:
+                for (std::size_t index = 0; index + words_per_row < from.size(); ++index)
+                {
+                    keep(index, from[index + words_per_row]);
+                }
+                for (std::size_t index = from.size() - std::min(words_per_row, from.size()); index < from.size(); ++index)
+                {
+                    to[index] = 0;
+                }
+                break;
+            }
+            return any != 0;
+        }
+    }
+
+    std::size_t trace_grid(const BitboardGrid &grid, const XY &entry_location, const Direction &entry_direction)
+    {
+        auto [x, y] = entry_location;
+        if (x < 0 || y < 0 || x >= grid.width() || y >= grid.height())
+        {
+            return 0;
+        }
+        const auto words_per_row = grid.words_per_row();
+        const auto plane_size = static_cast<std::size_t>(grid.height()) * words_per_row;
+        const auto tail_bits = static_cast<unsigned>(grid.width() % 64);
+        const std::uint64_t last_word_mask = tail_bits == 0 ? ~std::uint64_t(0) : (std::uint64_t(1) << tail_bits) - 1;
+
+        std::array<BitboardGrid::Plane, 4> front;
+        std::array<BitboardGrid::Plane, 4> visited;
+        std::array<BitboardGrid::Plane, 4> leaving;
+        for (std::size_t d = 0; d < 4; ++d)
+        {
+            front[d].assign(plane_size, 0);
+            visited[d].assign(plane_size, 0);
+            leaving[d].assign(plane_size, 0);
+        }
+        auto word = static_cast<std::size_t>(y) * words_per_row + static_cast<std::size_t>(x / 64);
+        front[static_cast<std::size_t>(entry_direction)][word] = std::uint64_t(1) << (x % 64);
+        visited[static_cast<std::size_t>(entry_direction)][word] = front[static_cast<std::size_t>(entry_direction)][word];
+
+        bool alive = true;
+        while (alive)
+        {
+            // Where each beam front leaves its cell, by exit direction
+            for (auto &plane : leaving)
+            {
+                std::fill(plane.begin(), plane.end(), 0);
+            }
+            for (const auto &pair : grid.route_pairs())
+            {
+                const auto &route = grid.route(pair.entry, pair.exit);
+                const auto &from = front[static_cast<std::size_t>(pair.entry)];
+                auto &to = leaving[static_cast<std::size_t>(pair.exit)];
+                for (std::size_t i = 0; i < plane_size; ++i)
+                {
+                    to[i] |= from[i] & route[i];
+                }
+            }
+            alive = false;
+            for (std::size_t d = 0; d < 4; ++d)
+            {
+                alive |= advance(leaving[d], front[d], visited[d], static_cast<Direction>(d), words_per_row, last_word_mask);
+            }
+        }
+
+        std::size_t energized = 0;
+        for (std::size_t i = 0; i < plane_size; ++i)
+        {
+            energized += static_cast<std::size_t>(std::popcount(visited[0][i] | visited[1][i] | visited[2][i] | visited[3][i]));
+        }
+        return energized;
+    }
+}
@@ -1,4 +1,5 @@
 #include "cells.h"
+#include <algorithm>
 #include <stdexcept>
 #include <iostream>
 #include <sys/types.h>
@@ -68,6 +69,26 @@ namespace cells
         throw std::runtime_error("untested cell direction combination");
     }
 
+    const Exits &exits(const Cell &self, const Direction &entry)
+    {
+        static const auto table = []
+        {
+            std::array<std::array<Exits, 4>, 5> table{};
+            for (int cell = 0; cell < 5; ++cell)
+            {
+                for (int direction = 0; direction < 4; ++direction)
+                {
+                    auto next = next_directions(static_cast<Cell>(cell), static_cast<Direction>(direction));
+                    auto &exits = table[cell][direction];
+                    exits.count = next.size();
+                    std::copy(next.begin(), next.end(), exits.directions.begin());
+                }
+            }
+            return table;
+        }();
+        return table[static_cast<std::size_t>(self)][static_cast<std::size_t>(entry)];
+    }
+
     XY delta(const Direction &direction)
     {
         switch (direction)
@@ -84,17 +105,62 @@ namespace cells
         throw std::runtime_error("untested direction");
     };
 
+    std::vector<Cell> flatten(const Grid &grid)
+    {
+        std::vector<Cell> cells;
+        cells.reserve(static_cast<std::size_t>(grid.width() * grid.height()));
+        for (Coord y = 0; y < grid.height(); ++y)
+        {
+            for (Coord x = 0; x < grid.width(); ++x)
+            {
+                cells.push_back(grid.cell(x, y));
+            }
+        }
+        return cells;
+    }
+
     std::size_t trace_grid(const Grid &grid, const XY &entry_location, const Direction &entry_direction)
     {
-        // Active beams
-        std::vector<Beam> beams = {Beam(entry_location, entry_direction)};
+        const Beam source(entry_location, entry_direction);
+        return trace_grid(grid, std::span<const Beam>(&source, 1));
+    }
+
+    /// @brief Trace from sources, giving up once more than limit cells are occupied
+    /// or, when limits is given, once it asks the trace to stop
+    static TraceResult trace_until(const Grid &grid, std::span<const Beam> sources, std::size_t limit, const TraceLimits *limits)
+    {
+        // Active beams, every source seeded up front
+        std::vector<Beam> beams(sources.begin(), sources.end());
 
         // Keep track of where we've been
         auto occupy_grid = OccupyGrid(grid.width(), grid.height());
 
+        TraceResult result;
+        // Counting down to the next check costs one decrement per step when unlimited
+        const auto interval = limits ? std::max<std::size_t>(limits->check_interval, 1) : SIZE_MAX;
+        auto until_check = interval;
+
         // Keep ray tracing until we run out of beams
         while (!beams.empty())
         {
+            // Checked once every interval steps, after the steps are taken
+            if (until_check == 0 && limits)
+            {
+                until_check = interval;
+                if (limits->progress)
+                {
+                    limits->progress(result.steps, occupy_grid.occupied_count());
+                }
+                if ((limits->cancel && limits->cancel->cancelled()) ||
+                    (limits->deadline && std::chrono::steady_clock::now() >= *limits->deadline))
+                {
+                    result.complete = false;
+                    break;
+                }
+            }
+            result.steps++;
+            --until_check;
+
             auto beam = beams.back();
             beams.pop_back();
 
@@ -109,12 +175,33 @@ namespace cells
 
             if (occupy_grid.visit(beam.location, beam.direction))
             {
+                if (occupy_grid.occupied_count() > limit)
+                {
+                    break;
+                }
                 auto next_possible = next_possible_beams(cell, beam.direction, beam.location);
                 // populate beams with the contents of next_possible
                 beams.insert(beams.end(), next_possible.begin(), next_possible.end());
             }
         }
-        return occupy_grid.occupied_count();
+        result.energized = occupy_grid.occupied_count();
+        return result;
+    }
+
+    std::size_t trace_grid(const Grid &grid, std::span<const Beam> sources)
+    {
+        return trace_until(grid, sources, SIZE_MAX, nullptr).energized;
     }
 
-}
\ No newline at end of file
+    bool trace_exceeds(const Grid &grid, const XY &entry_location, const Direction &entry_direction, std::size_t threshold)
+    {
+        const Beam source(entry_location, entry_direction);
+        return trace_until(grid, std::span<const Beam>(&source, 1), threshold, nullptr).energized > threshold;
+    }
+
+    TraceResult trace_grid(const Grid &grid, const XY &entry_location, const Direction &entry_direction, const TraceLimits &limits)
+    {
+        const Beam source(entry_location, entry_direction);
+        return trace_until(grid, std::span<const Beam>(&source, 1), SIZE_MAX, &limits);
+    }
+}
@@ -0,0 +1,60 @@
+#include "coroutine_behavior.h"
+
+namespace state_machine
+{
+    std::size_t CoroutineButtonBehavior::frame_size()
+    {
+        // Every frame of run() has the same size, measure it once on a throwaway instance
+        static const std::size_t size = []
+        {
+            struct NullIO : IIO
+            {
+                void set_light(OnOff) override {}
+                bool button_pressed() override { return false; }
+                bool button_released() override { return true; }
+            } io;
+            struct NullTimer : ITimer
+            {
+                ITimer &reset(double) override { return *this; }
+                bool expired() const override { return false; }
+            } timer;
+            CoroutineButtonBehavior behavior(io, timer);
+            return FrameTask::promise_type::last_frame_size;
+        }();
+        return size;
+    }
+
+    FrameTask CoroutineButtonBehavior::run()
+    {
+        io.set_light(OnOff::Off);
+        while (true)
+        {
+            current_state = States::NotPressed;
+            while (!io.button_pressed())
+            {
+                co_await std::suspend_always{};
+            }
+
+            // Flash until the button is released
+            OnOff light_state = OnOff::On;
+            current_state = States::BlinkOn;
+            io.set_light(light_state);
+            timer.reset(1.0);
+            while (!io.button_released())
+            {
+                if (timer.expired())
+                {
+                    timer.reset(1.0);
+                    light_state = toggle(light_state);
+                    io.set_light(light_state);
+                    current_state = (light_state == OnOff::On) ? States::BlinkOn : States::BlinkOff;
+                    continue;
+                }
+                co_await std::suspend_always{};
+            }
+
+            current_state = States::ReleasedButton;
+            io.set_light(OnOff::Off);
+        }
+    }
+}
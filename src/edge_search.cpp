@@ -0,0 +1,253 @@
+#include "edge_search.h"
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+
+namespace cells
+{
+    std::size_t EdgeSweep::best() const
+    {
+        std::size_t best = 0;
+        for (std::size_t i = 1; i < energized.size(); ++i)
+        {
+            if (energized[i] > energized[best])
+            {
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    namespace
+    {
+        /// Flat copy of a grid with a reusable visited array.  Only the cells a
+        /// trace touched are cleared afterwards, so tracing many small groups on
+        /// a large grid does not cost O(width * height) each.
+        class FlatTracer
+        {
+        public:
+            explicit FlatTracer(const Grid &grid) : width(grid.width()), height(grid.height()), cells(flatten(grid))
+            {
+                directions.assign(cells.size(), 0);
+            }
+
+            Cell at(Coord x, Coord y) const
+            {
+                return cells[index(x, y)];
+            }
+            bool inside(Coord x, Coord y) const
+            {
+                return x >= 0 && y >= 0 && x < width && y < height;
+            }
+            bool energized(Coord x, Coord y) const
+            {
+                return directions[index(x, y)] != 0;
+            }
+
+            /// Marks (x, y) energized and traces each exit beam leaving it, returns the energized count
+            std::size_t trace_from(Coord x, Coord y, const Exits &leaving)
+            {
+                clear();
+                // Energized without claiming any direction, a beam may still come back through it
+                mark(index(x, y), 0x10);
+                for (std::size_t i = 0; i < leaving.count; ++i)
+                {
+                    auto [dx, dy] = delta(leaving.directions[i]);
+                    push(x + dx, y + dy, leaving.directions[i]);
+                }
+                walk_beams(beams, beams, width, height, [this](Coord x, Coord y, Direction direction) -> std::optional<Cell>
+                           {
+                    auto cell = index(x, y);
+                    auto bit = static_cast<std::uint8_t>(1 << static_cast<int>(direction));
+                    if (directions[cell] & bit)
+                    {
+                        return std::nullopt;
+                    }
+                    mark(cell, bit);
+                    return cells[cell]; });
+                return touched.size();
+            }
+
+        private:
+            std::size_t index(Coord x, Coord y) const
+            {
+                return static_cast<std::size_t>(y * width + x);
+            }
+            void push(Coord x, Coord y, Direction direction)
+            {
+                if (inside(x, y))
+                {
+                    beams.push_back({x, y, direction});
+                }
+            }
+            void mark(std::size_t cell, std::uint8_t bits)
+            {
+                if (directions[cell] == 0)
+                {
+                    touched.push_back(cell);
+                }
+                directions[cell] |= bits;
+            }
+            void clear()
+            {
+                for (auto cell : touched)
+                {
+                    directions[cell] = 0;
+                }
+                touched.clear();
+            }
+
+            Coord width;
+            Coord height;
+            std::vector<Cell> cells;
+            std::vector<std::uint8_t> directions;
+            std::vector<std::size_t> touched;
+            std::vector<BeamAt<Coord>> beams;
+        };
+
+        /// Follow an entry through empty space and mirrors, calling visit(x, y)
+        /// for every cell on the way, until it reaches the flat side of a splitter.
+        /// A path of mirrors is reversible, so one that starts at the edge cannot
+        /// loop and ends either at a splitter or off the grid.
+        /// @return the splitter reached, if any
+        template <typename Visit>
+        std::optional<XY> walk_to_splitter(const FlatTracer &tracer, const Entry &entry, Visit &&visit)
+        {
+            auto [x, y] = entry.location;
+            auto direction = entry.direction;
+            while (tracer.inside(x, y))
+            {
+                const auto &next = exits(tracer.at(x, y), direction);
+                if (next.count == 2)
+                {
+                    return XY{x, y};
+                }
+                visit(x, y);
+                direction = next.directions[0];
+                auto [dx, dy] = delta(direction);
+                x += dx;
+                y += dy;
+            }
+            return std::nullopt;
+        }
+    }
+
+    EdgeSweep sweep_edges(const Grid &grid)
+    {
+        EdgeSweep sweep;
+        sweep.entries = edge_entries(grid.width(), grid.height());
+        sweep.energized.assign(sweep.entries.size(), 0);
+        FlatTracer tracer(grid);
+
+        // A path can cross itself, stamps count each of its cells once
+        std::vector<std::size_t> stamps(static_cast<std::size_t>(grid.width() * grid.height()), 0);
+        std::size_t stamp = 0;
+        auto first_visit = [&](Coord x, Coord y)
+        {
+            auto &cell = stamps[static_cast<std::size_t>(y * grid.width() + x)];
+            return std::exchange(cell, stamp) != stamp;
+        };
+
+        // Entries by the splitter they reach, each traced as a group from there
+        std::unordered_map<std::size_t, std::vector<std::size_t>> groups;
+        std::vector<XY> splitters;
+        for (std::size_t i = 0; i < sweep.entries.size(); ++i)
+        {
+            ++stamp;
+            std::size_t path = 0;
+            auto splitter = walk_to_splitter(tracer, sweep.entries[i], [&](Coord x, Coord y)
+                                             { path += first_visit(x, y) ? 1 : 0; });
+            if (!splitter)
+            {
+                // Only mirrors and space all the way out of the grid
+                sweep.energized[i] = path;
+                continue;
+            }
+            auto [x, y] = *splitter;
+            auto &members = groups[static_cast<std::size_t>(y * grid.width() + x)];
+            if (members.empty())
+            {
+                splitters.push_back(*splitter);
+            }
+            members.push_back(i);
+        }
+
+        for (const auto &splitter : splitters)
+        {
+            auto [x, y] = splitter;
+            const auto &members = groups[static_cast<std::size_t>(y * grid.width() + x)];
+            // Either flat side splits into the same two beams
+            const auto cell = tracer.at(x, y);
+            const auto &leaving = exits(cell, cell == Cell::Vertical ? Direction::Right : Direction::Down);
+            auto shared = tracer.trace_from(x, y, leaving);
+            sweep.full_traces++;
+            for (auto i : members)
+            {
+                // Path cells the rest of the trace did not reach on its own
+                ++stamp;
+                std::size_t extra = 0;
+                walk_to_splitter(tracer, sweep.entries[i], [&](Coord x, Coord y)
+                                 { extra += first_visit(x, y) && !tracer.energized(x, y) ? 1 : 0; });
+                sweep.energized[i] = shared + extra;
+            }
+        }
+        return sweep;
+    }
+
+    TopEdges top_edges(const BeamGraph &graph, std::size_t k)
+    {
+        TopEdges top;
+        if (k == 0)
+        {
+            return top;
+        }
+        auto entries = edge_entries(graph.width(), graph.height());
+        std::vector<std::pair<std::size_t, std::size_t>> bounds; // (bound, entry)
+        bounds.reserve(entries.size());
+        for (std::size_t i = 0; i < entries.size(); ++i)
+        {
+            bounds.emplace_back(graph.upper_bound(entries[i].location, entries[i].direction), i);
+        }
+        std::sort(bounds.begin(), bounds.end(), [](const auto &a, const auto &b)
+                  { return a.first != b.first ? a.first > b.first : a.second < b.second; });
+
+        // Min-heap of (count, entry) holding the best k so far
+        using Scored = std::pair<std::size_t, std::size_t>;
+        std::priority_queue<Scored, std::vector<Scored>, std::greater<Scored>> best;
+        for (auto [bound, entry] : bounds)
+        {
+            if (best.size() == k && bound <= best.top().first)
+            {
+                break;
+            }
+            auto count = graph.trace(entries[entry].location, entries[entry].direction);
+            top.exact_traces++;
+            if (best.size() < k)
+            {
+                best.emplace(count, entry);
+            }
+            else if (count > best.top().first)
+            {
+                best.pop();
+                best.emplace(count, entry);
+            }
+        }
+
+        std::vector<Scored> ranked;
+        for (; !best.empty(); best.pop())
+        {
+            ranked.push_back(best.top());
+        }
+        std::reverse(ranked.begin(), ranked.end());
+        for (auto [count, entry] : ranked)
+        {
+            top.entries.push_back(entries[entry]);
+            top.energized.push_back(count);
+        }
+        return top;
+    }
+}
@@ -0,0 +1,139 @@
+#include "executive.h"
+
+namespace state_machine
+{
+    ITimer &Executive::Timer::reset(double seconds)
+    {
+        deadline_ = executive.now() + seconds;
+        generation_++;
+        executive.schedule(*this);
+        return *this;
+    }
+
+    SignalId Executive::add_signal()
+    {
+        signals_.emplace_back();
+        return signals_.size() - 1;
+    }
+
+    void Executive::signal(SignalId signal)
+    {
+        auto &state = signals_[signal];
+        state.version = ++sequence_;
+        for (const auto &waiter : state.waiters)
+        {
+            if (behaviors_[waiter.behavior].epoch == waiter.epoch)
+            {
+                make_ready(waiter.behavior);
+            }
+        }
+        // Keeps its capacity, so steady state signaling does not allocate
+        state.waiters.clear();
+    }
+
+    Executive::Timer &Executive::add_timer()
+    {
+        return timers_.emplace_back(*this, add_signal());
+    }
+
+    void Executive::add(IWaitingBehavior &behavior)
+    {
+        behaviors_.push_back({&behavior});
+        make_ready(behaviors_.size() - 1);
+    }
+
+    void Executive::frame(double now)
+    {
+        now_ = now;
+        while (!wakeups_.empty() && wakeups_.top().time <= now_)
+        {
+            auto wakeup = wakeups_.top();
+            wakeups_.pop();
+            // Skip wakeups for timers that were reset since
+            if (wakeup.generation == wakeup.timer->generation_)
+            {
+                signal(wakeup.timer->signal_);
+            }
+        }
+
+        std::swap(ready_, running_);
+        for (auto index : running_)
+        {
+            auto &state = behaviors_[index];
+            state.ready = false;
+            state.epoch++;
+            state.started = sequence_;
+            state.behavior->do_work();
+            runs_++;
+
+            wait_set_.clear();
+            state.behavior->waiting_on(wait_set_);
+            if (wait_set_.empty())
+            {
+                make_ready(index);
+                continue;
+            }
+            for (auto signal : wait_set_)
+            {
+                auto &signal_state = signals_[signal];
+                if (signal_state.version > state.started)
+                {
+                    // Changed while the behavior was running, it has not seen it yet
+                    make_ready(index);
+                }
+                else
+                {
+                    subscribe(signal_state, index);
+                }
+            }
+        }
+        running_.clear();
+    }
+
+    void Executive::make_ready(std::size_t behavior)
+    {
+        auto &state = behaviors_[behavior];
+        if (!state.ready)
+        {
+            state.ready = true;
+            ready_.push_back(behavior);
+        }
+    }
+
+    void Executive::subscribe(SignalState &signal, std::size_t behavior)
+    {
+        auto &waiters = signal.waiters;
+        // A signal that never fires is never cleared, so drop subscriptions from
+        // earlier runs before growing.  Growth only happens when at least half
+        // are live, which keeps the list within twice its live size.
+        if (waiters.size() == waiters.capacity())
+        {
+            std::erase_if(waiters, [this](const Subscription &waiter)
+                          { return behaviors_[waiter.behavior].epoch != waiter.epoch; });
+        }
+        waiters.push_back({behavior, behaviors_[behavior].epoch});
+    }
+
+    void Executive::schedule(Timer &timer)
+    {
+        wakeups_.push({timer.deadline_, &timer, timer.generation_});
+    }
+
+    void ScheduledButtonBehavior::waiting_on(WaitSet &set) const
+    {
+        switch (behavior.get_state())
+        {
+        case PolledButtonBehavior::States::NotPressed:
+            set.add(io.button_signal());
+            break;
+        case PolledButtonBehavior::States::BlinkOn:
+        case PolledButtonBehavior::States::BlinkOff:
+            set.add(io.button_signal());
+            set.add(timer.signal());
+            break;
+        case PolledButtonBehavior::States::ReleasedButton:
+            // Transient, leave the set empty so it runs again next frame
+            break;
+        }
+    }
+}
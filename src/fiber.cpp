@@ -0,0 +1,276 @@
+#include "fiber.h"
+#include <algorithm>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#if defined(__x86_64__)
+// switch_fiber saves the callee saved registers and the SSE/x87 control words
+// on the current stack, stores the stack pointer in *from, and restores the
+// same from to.  A new fiber's stack is prepared so the restore "returns" into
+// fiber_trampoline, which calls r13(r12).
+extern "C" void state_machine_switch_fiber(void **from, void *to);
+extern "C" void state_machine_fiber_trampoline();
+asm(R"(
+    .text
+    .globl state_machine_switch_fiber
+    .type state_machine_switch_fiber, @function
+state_machine_switch_fiber:
+    pushq %rbp
+    pushq %rbx
+    pushq %r12
+    pushq %r13
+    pushq %r14
+    pushq %r15
+    subq $8, %rsp
+    stmxcsr (%rsp)
+    fnstcw 4(%rsp)
+    movq %rsp, (%rdi)
+    movq %rsi, %rsp
+    ldmxcsr (%rsp)
+    fldcw 4(%rsp)
+    addq $8, %rsp
+    popq %r15
+    popq %r14
+    popq %r13
+    popq %r12
+    popq %rbx
+    popq %rbp
+    ret
+    .size state_machine_switch_fiber, .-state_machine_switch_fiber
+
+    .globl state_machine_fiber_trampoline
+    .type state_machine_fiber_trampoline, @function
+state_machine_fiber_trampoline:
+    movq %r12, %rdi
+    callq *%r13
+    ud2
+    .size state_machine_fiber_trampoline, .-state_machine_fiber_trampoline
+)");
+#else
+#include <ucontext.h>
+#endif
+
+namespace state_machine
+{
+    namespace
+    {
+        /// Thrown out of yield() to unwind a fiber that is being cancelled
+        struct FiberCancelled
+        {
+        };
+
+#if defined(__x86_64__)
+        struct Context
+        {
+            void *sp = nullptr;
+        };
+
+        void prepare(Context &context, void *stack, std::size_t size, void (*entry)(void *), void *argument)
+        {
+            auto top = (reinterpret_cast<std::uintptr_t>(stack) + size) & ~std::uintptr_t(15);
+            // Control words, r15, r14, r13, r12, rbx, rbp, return address, then alignment padding
+            auto frame = reinterpret_cast<std::uint64_t *>(top - 80);
+            std::uint32_t mxcsr;
+            std::uint16_t fpucw;
+            asm volatile("stmxcsr %0" : "=m"(mxcsr));
+            asm volatile("fnstcw %0" : "=m"(fpucw));
+            frame[0] = mxcsr | (static_cast<std::uint64_t>(fpucw) << 32);
+            frame[1] = 0;
+            frame[2] = 0;
+            frame[3] = reinterpret_cast<std::uint64_t>(entry);
+            frame[4] = reinterpret_cast<std::uint64_t>(argument);
+            frame[5] = 0;
+            frame[6] = 0;
+            frame[7] = reinterpret_cast<std::uint64_t>(&state_machine_fiber_trampoline);
+            frame[8] = 0;
+            frame[9] = 0;
+            context.sp = frame;
+        }
+
+        void switch_context(Context &from, Context &to)
+        {
+            state_machine_switch_fiber(&from.sp, to.sp);
+        }
+#else
+        /// Where a new fiber starts, read by the trampoline on the fiber's stack
+        struct Start
+        {
+            void (*entry)(void *);
+            void *argument;
+        };
+
+        struct Context
+        {
+            ucontext_t context;
+            Start start;
+        };
+
+        void start_fiber(unsigned high, unsigned low)
+        {
+            auto &start = *reinterpret_cast<Start *>((static_cast<std::uintptr_t>(high) << 32) | low);
+            start.entry(start.argument);
+        }
+
+        void prepare(Context &context, void *stack, std::size_t size, void (*entry)(void *), void *argument)
+        {
+            getcontext(&context.context);
+            context.context.uc_stack.ss_sp = stack;
+            context.context.uc_stack.ss_size = size;
+            context.context.uc_link = nullptr;
+            context.start = {entry, argument};
+            // makecontext only passes int arguments, split the pointer in two
+            auto bits = reinterpret_cast<std::uintptr_t>(&context.start);
+            makecontext(&context.context, reinterpret_cast<void (*)()>(&start_fiber),
+                        2, static_cast<unsigned>(bits >> 32), static_cast<unsigned>(bits));
+        }
+
+        void switch_context(Context &from, Context &to)
+        {
+            swapcontext(&from.context, &to.context);
+        }
+#endif
+    }
+
+    struct FiberScheduler::Fiber
+    {
+        std::function<void()> body;
+        void *stack = nullptr;
+        Context context;
+        Context scheduler;
+        bool started = false;
+        bool done = false;
+        bool cancelled = false;
+    };
+
+    namespace
+    {
+        thread_local FiberScheduler::Fiber *current_fiber = nullptr;
+
+        // Anything but cancellation escaping a fiber terminates, as for FrameTask
+        void fiber_main(void *argument) noexcept
+        {
+            auto &fiber = *static_cast<FiberScheduler::Fiber *>(argument);
+            try
+            {
+                fiber.body();
+            }
+            catch (const FiberCancelled &)
+            {
+            }
+            fiber.done = true;
+            // Never resumed again, the scheduler releases the stack
+            switch_context(fiber.context, fiber.scheduler);
+        }
+    }
+
+    FiberStackPool::FiberStackPool(std::size_t stack_size)
+    {
+        auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        guard_size_ = page;
+        stack_size_ = (stack_size + page - 1) / page * page;
+    }
+
+    FiberStackPool::~FiberStackPool()
+    {
+        for (auto mapping : mapped_)
+        {
+            ::munmap(mapping, guard_size_ + stack_size_);
+        }
+    }
+
+    void *FiberStackPool::acquire()
+    {
+        if (!free_.empty())
+        {
+            auto stack = free_.back();
+            free_.pop_back();
+            return stack;
+        }
+        auto mapping = ::mmap(nullptr, guard_size_ + stack_size_, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (mapping == MAP_FAILED)
+        {
+            throw std::runtime_error("unable to map fiber stack");
+        }
+        // Stacks grow down, an overflow runs into the guard page at the bottom
+        if (::mprotect(mapping, guard_size_, PROT_NONE) != 0)
+        {
+            ::munmap(mapping, guard_size_ + stack_size_);
+            throw std::runtime_error("unable to protect fiber stack guard page");
+        }
+        mapped_.push_back(mapping);
+        return static_cast<char *>(mapping) + guard_size_;
+    }
+
+    void FiberStackPool::release(void *stack)
+    {
+        free_.push_back(stack);
+    }
+
+    FiberScheduler::FiberScheduler(std::size_t stack_size) : stacks_(stack_size) {}
+
+    FiberScheduler::~FiberScheduler()
+    {
+        for (auto &fiber : fibers_)
+        {
+            if (fiber->started)
+            {
+                fiber->cancelled = true;
+                resume(*fiber);
+            }
+            stacks_.release(fiber->stack);
+        }
+    }
+
+    void FiberScheduler::spawn(std::function<void()> body)
+    {
+        auto fiber = std::make_unique<Fiber>();
+        fiber->body = std::move(body);
+        fiber->stack = stacks_.acquire();
+        prepare(fiber->context, fiber->stack, stacks_.stack_size(), &fiber_main, fiber.get());
+        fibers_.push_back(std::move(fiber));
+    }
+
+    void FiberScheduler::resume(Fiber &fiber)
+    {
+        auto outer = current_fiber;
+        current_fiber = &fiber;
+        fiber.started = true;
+        switch_context(fiber.scheduler, fiber.context);
+        current_fiber = outer;
+    }
+
+    std::size_t FiberScheduler::round()
+    {
+        // Fibers spawned during the round start on the next one
+        const auto count = fibers_.size();
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            resume(*fibers_[i]);
+        }
+        std::erase_if(fibers_, [this](const std::unique_ptr<Fiber> &fiber)
+                      {
+            if (fiber->done)
+            {
+                stacks_.release(fiber->stack);
+            }
+            return fiber->done; });
+        rounds_++;
+        return fibers_.size();
+    }
+
+    void FiberScheduler::yield()
+    {
+        auto fiber = current_fiber;
+        if (!fiber)
+        {
+            throw std::runtime_error("yield called outside of a fiber");
+        }
+        switch_context(fiber->context, fiber->scheduler);
+        if (fiber->cancelled)
+        {
+            throw FiberCancelled{};
+        }
+    }
+}
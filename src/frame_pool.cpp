@@ -0,0 +1,39 @@
+#include "frame_pool.h"
+
+namespace state_machine
+{
+    FramePool::~FramePool()
+    {
+        // Coroutines still parked are never resumed, detach them so destroying them later is safe
+        while (parked.next != &parked)
+        {
+            parked.next->unlink();
+        }
+    }
+
+    std::size_t FramePool::frame()
+    {
+        // Everything in front of the marker was parked before this frame
+        marker.prev = parked.prev;
+        marker.next = &parked;
+        parked.prev->next = &marker;
+        parked.prev = &marker;
+
+        std::size_t resumed = 0;
+        while (parked.next != &marker)
+        {
+            auto &awaiter = static_cast<FrameAwaiter &>(*parked.next);
+            awaiter.unlink();
+            count--;
+            if (awaiter.blocked)
+            {
+                *awaiter.blocked = {};
+            }
+            // The awaiter lives in the coroutine frame and may be gone after this
+            awaiter.handle.resume();
+            resumed++;
+        }
+        marker.unlink();
+        return resumed;
+    }
+}
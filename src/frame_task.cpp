@@ -0,0 +1,87 @@
+#include "frame_task.h"
+#include <array>
+#include <new>
+
+namespace state_machine
+{
+    namespace
+    {
+        struct FreeFrame
+        {
+            FreeFrame *next;
+        };
+
+        /// Free list for each size class, owned by its thread and freed when it exits
+        struct FreeLists
+        {
+            std::array<FreeFrame *, 16> heads{};
+            std::array<std::size_t, 16> counts{};
+
+            ~FreeLists();
+        };
+
+        thread_local FreeLists free_frames;
+        // Set once this thread's lists are gone, trivially destructible so it outlives them
+        thread_local bool free_frames_destroyed = false;
+
+        FreeLists::~FreeLists()
+        {
+            for (auto &head : heads)
+            {
+                while (head)
+                {
+                    auto next = head->next;
+                    ::operator delete(head);
+                    head = next;
+                }
+            }
+            free_frames_destroyed = true;
+        }
+    }
+
+    void *FrameRecycler::allocate(std::size_t size)
+    {
+        auto size_class = (size + granularity - 1) / granularity;
+        if (size_class >= classes)
+        {
+            return ::operator new(size);
+        }
+        if (free_frames_destroyed)
+        {
+            return ::operator new(size_class * granularity);
+        }
+        if (auto frame = free_frames.heads[size_class])
+        {
+            free_frames.heads[size_class] = frame->next;
+            free_frames.counts[size_class]--;
+            return frame;
+        }
+        return ::operator new(size_class * granularity);
+    }
+
+    void FrameRecycler::release(void *frame, std::size_t size)
+    {
+        auto size_class = (size + granularity - 1) / granularity;
+        if (size_class >= classes || free_frames_destroyed || free_frames.counts[size_class] == max_cached)
+        {
+            ::operator delete(frame);
+            return;
+        }
+        free_frames.heads[size_class] = new (frame) FreeFrame{free_frames.heads[size_class]};
+        free_frames.counts[size_class]++;
+    }
+
+    std::size_t FrameRecycler::cached()
+    {
+        if (free_frames_destroyed)
+        {
+            return 0;
+        }
+        std::size_t total = 0;
+        for (auto count : free_frames.counts)
+        {
+            total += count;
+        }
+        return total;
+    }
+}
@@ -0,0 +1,281 @@
+#include "grid_registry.h"
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace cells
+{
+    namespace
+    {
+        const char segment_magic[8] = {'B', 'E', 'A', 'M', 'S', 'H', 'M', '1'};
+
+        /// Contents of the per-name segment.  reserved hands out versions,
+        /// current is the newest fully written one.
+        struct RegistryIndex
+        {
+            std::uint64_t reserved;
+            std::uint64_t current;
+        };
+
+        std::size_t page_size()
+        {
+            return static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        }
+
+        /// Shared memory object mapped for as long as this lives
+        class Mapping
+        {
+        public:
+            /// A segment created with O_EXCL gets mode regardless of the umask,
+            /// and is unlinked again if it cannot be sized or mapped.
+            Mapping(const std::string &name, int flags, std::size_t size, int protection, mode_t mode = 0644) : size_(size)
+            {
+                int fd = ::shm_open(name.c_str(), flags, mode);
+                if (fd < 0)
+                {
+                    missing_ = errno == ENOENT;
+                    if (missing_)
+                    {
+                        return;
+                    }
+                    throw std::runtime_error("unable to open shared memory " + name + ": " + std::strerror(errno));
+                }
+                const bool created = (flags & O_CREAT) && (flags & O_EXCL);
+                auto fail = [&](const std::string &what)
+                {
+                    ::close(fd);
+                    if (created)
+                    {
+                        ::shm_unlink(name.c_str());
+                    }
+                    throw std::runtime_error(what + " " + name);
+                };
+                if (created && ::fchmod(fd, mode) != 0)
+                {
+                    fail("unable to set the mode of shared memory");
+                }
+                if ((flags & O_CREAT) && ::ftruncate(fd, static_cast<off_t>(size)) != 0)
+                {
+                    fail("unable to size shared memory");
+                }
+                // Created but not yet sized by its publisher, touching it would fault
+                struct stat info;
+                if (!(flags & O_CREAT) && (::fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < size))
+                {
+                    ::close(fd);
+                    missing_ = true;
+                    return;
+                }
+                data_ = ::mmap(nullptr, size, protection, MAP_SHARED, fd, 0);
+                if (data_ == MAP_FAILED)
+                {
+                    data_ = nullptr;
+                    fail("unable to map shared memory");
+                }
+                ::close(fd);
+            }
+            Mapping(const Mapping &) = delete;
+            Mapping &operator=(const Mapping &) = delete;
+            ~Mapping()
+            {
+                if (data_)
+                {
+                    ::munmap(data_, size_);
+                }
+            }
+
+            bool missing() const
+            {
+                return missing_;
+            }
+            template <typename T>
+            T *as() const
+            {
+                return static_cast<T *>(data_);
+            }
+
+        private:
+            std::size_t size_;
+            void *data_ = nullptr;
+            bool missing_ = false;
+        };
+    }
+
+    SharedGrid::SharedGrid(SharedGrid &&other) noexcept : header_(other.header_), readers_(other.readers_), grid_(std::move(other.grid_))
+    {
+        other.header_ = nullptr;
+        other.readers_ = nullptr;
+    }
+
+    SharedGrid::~SharedGrid()
+    {
+        if (header_)
+        {
+            std::atomic_ref(*readers_).fetch_sub(1);
+            ::munmap(readers_, sizeof(std::uint64_t));
+            ::munmap(const_cast<SharedGridHeader *>(header_), page_size());
+        }
+    }
+
+    std::uint64_t SharedGrid::readers() const
+    {
+        return std::atomic_ref(*readers_).load();
+    }
+
+    std::string GridRegistry::index_name(const std::string &name) const
+    {
+        if (name.empty() || name.find('/') != std::string::npos)
+        {
+            throw std::runtime_error("invalid shared grid name " + name);
+        }
+        return "/" + prefix_ + "." + name;
+    }
+
+    std::string GridRegistry::segment_name(const std::string &name, std::uint64_t version) const
+    {
+        return index_name(name) + "." + std::to_string(version);
+    }
+
+    void GridRegistry::unlink_version(const std::string &name, std::uint64_t version) const
+    {
+        const auto segment = segment_name(name, version);
+        ::shm_unlink(segment.c_str());
+        ::shm_unlink((segment + ".readers").c_str());
+    }
+
+    std::uint64_t GridRegistry::current_version(const std::string &name) const
+    {
+        Mapping index(index_name(name), O_RDONLY, sizeof(RegistryIndex), PROT_READ);
+        if (index.missing())
+        {
+            return 0;
+        }
+        // atomic_ref needs a non-const object; the load does not write
+        return std::atomic_ref(const_cast<RegistryIndex *>(index.as<const RegistryIndex>())->current).load();
+    }
+
+    std::uint64_t GridRegistry::publish(const std::string &name, const Grid &grid, std::uint32_t tile_size)
+    {
+        Mapping index(index_name(name), O_CREAT | O_RDWR, sizeof(RegistryIndex), PROT_READ | PROT_WRITE);
+        auto *versions = index.as<RegistryIndex>();
+        const auto version = std::atomic_ref(versions->reserved).fetch_add(1) + 1;
+
+        // Fully written before any reader can find it
+        const auto segment = segment_name(name, version);
+        const auto image_size = tile_image_size(grid.width(), grid.height(), tile_size);
+        {
+            // Anyone who can read the grid may count themselves as its reader
+            Mapping readers(segment + ".readers", O_CREAT | O_EXCL | O_RDWR, sizeof(std::uint64_t), PROT_READ | PROT_WRITE, 0666);
+            try
+            {
+                Mapping data(segment, O_CREAT | O_EXCL | O_RDWR, page_size() + image_size, PROT_READ | PROT_WRITE);
+                auto *header = data.as<SharedGridHeader>();
+                std::memcpy(header->magic, segment_magic, sizeof(header->magic));
+                header->version = version;
+                write_tile_image(std::span(data.as<std::uint8_t>() + page_size(), image_size), grid, tile_size);
+            }
+            catch (...)
+            {
+                unlink_version(name, version);
+                throw;
+            }
+        }
+
+        // Publishes racing each other settle on the highest version
+        auto current = std::atomic_ref(versions->current);
+        auto replaced = current.load();
+        while (replaced < version && !current.compare_exchange_weak(replaced, version))
+        {
+        }
+        if (replaced > version)
+        {
+            unlink_version(name, version);
+        }
+        else if (replaced != 0)
+        {
+            unlink_version(name, replaced);
+        }
+        return version;
+    }
+
+    SharedGrid GridRegistry::open(const std::string &name) const
+    {
+        for (;;)
+        {
+            auto version = current_version(name);
+            if (version == 0)
+            {
+                throw std::runtime_error("no shared grid named " + name);
+            }
+            const auto segment = segment_name(name, version);
+            int fd = ::shm_open(segment.c_str(), O_RDONLY, 0);
+            if (fd < 0)
+            {
+                if (errno == ENOENT)
+                {
+                    // Replaced between reading the version and opening it
+                    continue;
+                }
+                throw std::runtime_error("unable to open shared memory " + segment + ": " + std::strerror(errno));
+            }
+            auto *header = static_cast<const SharedGridHeader *>(::mmap(nullptr, page_size(), PROT_READ, MAP_SHARED, fd, 0));
+            if (header == MAP_FAILED)
+            {
+                ::close(fd);
+                throw std::runtime_error("unable to map shared memory " + segment);
+            }
+            std::optional<MappedGrid> grid;
+            try
+            {
+                if (std::memcmp(header->magic, segment_magic, sizeof(segment_magic)) != 0 || header->version != version)
+                {
+                    throw std::runtime_error("not a shared grid " + segment);
+                }
+                grid.emplace(fd, page_size(), segment);
+            }
+            catch (const std::runtime_error &)
+            {
+                ::close(fd);
+                ::munmap(const_cast<SharedGridHeader *>(header), page_size());
+                throw;
+            }
+            ::close(fd);
+
+            int readers_fd = ::shm_open((segment + ".readers").c_str(), O_RDWR, 0);
+            void *readers = readers_fd < 0 ? MAP_FAILED : ::mmap(nullptr, sizeof(std::uint64_t), PROT_READ | PROT_WRITE, MAP_SHARED, readers_fd, 0);
+            const auto error = errno;
+            if (readers_fd >= 0)
+            {
+                ::close(readers_fd);
+            }
+            if (readers == MAP_FAILED)
+            {
+                ::munmap(const_cast<SharedGridHeader *>(header), page_size());
+                if (readers_fd < 0 && error == ENOENT)
+                {
+                    continue;
+                }
+                throw std::runtime_error("unable to open the reader count of " + segment + ": " + std::strerror(error));
+            }
+            auto *count = static_cast<std::uint64_t *>(readers);
+            std::atomic_ref(*count).fetch_add(1);
+            return SharedGrid(header, count, std::move(*grid));
+        }
+    }
+
+    void GridRegistry::remove(const std::string &name)
+    {
+        auto version = current_version(name);
+        ::shm_unlink(index_name(name).c_str());
+        if (version != 0)
+        {
+            unlink_version(name, version);
+        }
+    }
+}
@@ -0,0 +1,76 @@
+#include "grid_snapshot.h"
+#include <bit>
+#include <stdexcept>
+
+namespace cells
+{
+    GridEditor::GridEditor(const Grid &grid, std::uint32_t tile_size)
+    {
+        if (tile_size == 0 || !std::has_single_bit(tile_size))
+        {
+            throw std::runtime_error("tile size must be a power of two");
+        }
+        const Coord size = tile_size;
+        working_.width_ = grid.width();
+        working_.height_ = grid.height();
+        working_.tile_shift_ = static_cast<unsigned>(std::countr_zero(tile_size));
+        working_.tile_mask_ = size - 1;
+        working_.tiles_x_ = (grid.width() + size - 1) / size;
+        const Coord tiles_y = (grid.height() + size - 1) / size;
+        for (Coord tile_y = 0; tile_y < tiles_y; ++tile_y)
+        {
+            for (Coord tile_x = 0; tile_x < working_.tiles_x_; ++tile_x)
+            {
+                // Edge tiles are padded with Space, never visible through at()
+                auto tile = std::make_shared<GridSnapshot::Tile>(static_cast<std::size_t>(size * size), Cell::Space);
+                for (Coord y = 0; y < size; ++y)
+                {
+                    for (Coord x = 0; x < size; ++x)
+                    {
+                        if (auto cell = grid.at(tile_x * size + x, tile_y * size + y))
+                        {
+                            (*tile)[static_cast<std::size_t>(y * size + x)] = *cell;
+                        }
+                    }
+                }
+                working_.tiles_.push_back(std::move(tile));
+            }
+        }
+        owned_.resize(working_.tiles_.size());
+        publish();
+    }
+
+    void GridEditor::set(Coord x, Coord y, Cell cell)
+    {
+        if (!working_.at(x, y))
+        {
+            throw std::runtime_error("cell outside the grid");
+        }
+        const auto index = static_cast<std::size_t>((y >> working_.tile_shift_) * working_.tiles_x_ + (x >> working_.tile_shift_));
+        auto &tile = owned_[index];
+        if (!tile)
+        {
+            // First write since the last publish, readers may still hold the shared tile
+            tile = std::make_shared<GridSnapshot::Tile>(*working_.tiles_[index]);
+            working_.tiles_[index] = tile;
+            copied_++;
+        }
+        (*tile)[static_cast<std::size_t>(((y & working_.tile_mask_) << working_.tile_shift_) + (x & working_.tile_mask_))] = cell;
+    }
+
+    std::shared_ptr<const GridSnapshot> GridEditor::publish()
+    {
+        working_.version_++;
+        std::shared_ptr<const GridSnapshot> snapshot(new GridSnapshot(working_));
+        // From here on the snapshot shares every tile, the next write copies again
+        std::fill(owned_.begin(), owned_.end(), nullptr);
+        copied_ = 0;
+        current_.store(snapshot, std::memory_order_release);
+        return snapshot;
+    }
+
+    std::size_t trace_grid(const GridSnapshot &grid, const XY &entry_location, const Direction &entry_direction)
+    {
+        return trace_cells(grid, entry_location, entry_direction);
+    }
+}
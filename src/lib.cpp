@@ -1,4 +1,9 @@
 #include "lib.h"
+#include <algorithm>
+#include <exception>
+#include <random>
+#include <stdexcept>
+#include <thread>
 #include <ranges>
 
 static const char *sample_data = R"(.|...\....
@@ -36,23 +41,140 @@ namespace lib
             throw std::runtime_error("Invalid character in line");
         }
     }
-    auto line_to_cells(auto line)
+    /// @brief Parse the rows starting in [begin, end) into consecutive rows.
+    /// An empty row at the very end is left as it is.
+    static void parse_rows(const char *begin, const char *end, std::vector<cells::Cell> *rows)
     {
-        return line | std::views::transform(char_to_cell);
+        while (begin < end)
+        {
+            auto line_end = std::find(begin, end, '\n');
+            auto &row = *rows++;
+            row.resize(static_cast<std::size_t>(line_end - begin));
+            std::transform(begin, line_end, row.begin(), char_to_cell);
+            begin = line_end + 1;
+        }
+    }
+
+    cells::Grid lines_to_grid(const std::string &lines, unsigned threads)
+    {
+        // A single trailing newline ends the last row rather than starting an empty one
+        std::size_t size = lines.size();
+        if (size > 0 && lines[size - 1] == '\n')
+        {
+            size--;
+        }
+        const char *text = lines.data();
+
+        // Chunks of at least a megabyte, each starting at the beginning of a row
+        constexpr std::size_t min_chunk = 1 << 20;
+        if (threads == 0)
+        {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        const std::size_t chunks = std::clamp<std::size_t>(size / min_chunk, 1, threads);
+        std::vector<std::size_t> starts(chunks + 1, size);
+        starts[0] = 0;
+        for (std::size_t i = 1; i < chunks; ++i)
+        {
+            auto newline = std::find(text + std::max(starts[i - 1], size * i / chunks), text + size, '\n');
+            starts[i] = std::min<std::size_t>(static_cast<std::size_t>(newline - text) + 1, size);
+        }
+
+        auto run_chunks = [&](auto &&work)
+        {
+            std::vector<std::exception_ptr> errors(chunks);
+            std::vector<std::thread> workers;
+            for (std::size_t i = 1; i < chunks; ++i)
+            {
+                workers.emplace_back([&, i]
+                                     {
+                    try
+                    {
+                        work(i);
+                    }
+                    catch (...)
+                    {
+                        errors[i] = std::current_exception();
+                    } });
+            }
+            try
+            {
+                work(0);
+            }
+            catch (...)
+            {
+                errors[0] = std::current_exception();
+            }
+            for (auto &worker : workers)
+            {
+                worker.join();
+            }
+            for (auto &error : errors)
+            {
+                if (error)
+                {
+                    std::rethrow_exception(error);
+                }
+            }
+        };
+
+        // Rows starting in each chunk, then every chunk parses straight into its rows
+        std::vector<std::size_t> first_row(chunks + 1, 0);
+        run_chunks([&](std::size_t i)
+                   { first_row[i + 1] = static_cast<std::size_t>(std::count(text + starts[i], text + starts[i + 1], '\n')); });
+        if (!lines.empty())
+        {
+            // The last row has no newline of its own
+            first_row[chunks]++;
+        }
+        for (std::size_t i = 0; i < chunks; ++i)
+        {
+            first_row[i + 1] += first_row[i];
+        }
+        std::vector<std::vector<cells::Cell>> data(first_row[chunks]);
+        run_chunks([&](std::size_t i)
+                   { parse_rows(text + starts[i], text + starts[i + 1], data.data() + first_row[i]); });
+
+        for (const auto &row : data)
+        {
+            if (row.size() != data.front().size())
+            {
+                throw std::runtime_error("grid rows differ in length");
+            }
+        }
+        return cells::Grid(std::move(data));
     }
-    auto split_line_on_newline(const std::string &line)
+    std::string grid_to_lines(const cells::Grid &grid)
     {
-        return line | std::views::split('\n');
+        // Indexed by Cell, the inverse of char_to_cell
+        static constexpr char symbols[] = ".|-/\\";
+        std::string text;
+        text.reserve(static_cast<std::size_t>((grid.width() + 1) * grid.height()));
+        for (cells::Coord y = 0; y < grid.height(); ++y)
+        {
+            for (cells::Coord x = 0; x < grid.width(); ++x)
+            {
+                text.push_back(symbols[static_cast<std::size_t>(grid.cell(x, y))]);
+            }
+            text.push_back('\n');
+        }
+        return text;
     }
-    cells::Grid lines_to_grid(const std::string &lines)
+    cells::Grid random_grid(cells::Coord width, cells::Coord height, double obstacle_fraction, unsigned seed)
     {
-        std::vector<std::vector<cells::Cell>> data;
-        for (const auto &line : split_line_on_newline(lines))
+        std::mt19937 random(seed);
+        std::bernoulli_distribution is_obstacle(obstacle_fraction);
+        std::uniform_int_distribution<int> obstacle(1, 4);
+        std::vector<std::vector<cells::Cell>> data(height, std::vector<cells::Cell>(width, cells::Cell::Space));
+        for (auto &row : data)
         {
-            std::vector<cells::Cell> row;
-            auto cells = line_to_cells(line);
-            row.insert(row.end(), cells.begin(), cells.end());
-            data.push_back(row);
+            for (auto &cell : row)
+            {
+                if (is_obstacle(random))
+                {
+                    cell = static_cast<cells::Cell>(obstacle(random));
+                }
+            }
         }
         return cells::Grid(data);
     }
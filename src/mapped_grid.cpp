@@ -0,0 +1,300 @@
+#include "mapped_grid.h"
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace cells
+{
+    static const char tile_file_magic[8] = {'B', 'E', 'A', 'M', 'G', 'R', 'I', 'D'};
+
+    std::uint64_t tile_image_size(Coord width, Coord height, std::uint32_t tile_size)
+    {
+        if (tile_size == 0 || !std::has_single_bit(tile_size) || width < 0 || height < 0)
+        {
+            throw std::runtime_error("tile size must be a power of two");
+        }
+        const std::uint64_t tiles_x = (static_cast<std::uint64_t>(width) + tile_size - 1) / tile_size;
+        const std::uint64_t tiles_y = (static_cast<std::uint64_t>(height) + tile_size - 1) / tile_size;
+        std::uint64_t tiles = 0;
+        std::uint64_t cells = 0;
+        std::uint64_t size = 0;
+        if (__builtin_mul_overflow(tiles_x, tiles_y, &tiles) ||
+            __builtin_mul_overflow(tiles, static_cast<std::uint64_t>(tile_size) * tile_size, &cells) ||
+            __builtin_add_overflow(cells, sizeof(TileFileHeader), &size))
+        {
+            throw std::runtime_error("tiled grid too large");
+        }
+        return size;
+    }
+
+    /// @brief Produce a tile image in order, handing each run of bytes to write
+    static void emit_tile_image(Coord width, Coord height, std::uint32_t tile_size, const TileFiller &fill,
+                                const std::function<void(const std::uint8_t *, std::size_t)> &write)
+    {
+        tile_image_size(width, height, tile_size);
+
+        TileFileHeader header{};
+        std::memcpy(header.magic, tile_file_magic, sizeof(header.magic));
+        header.width = static_cast<std::uint64_t>(width);
+        header.height = static_cast<std::uint64_t>(height);
+        header.tile_size = tile_size;
+        write(reinterpret_cast<const std::uint8_t *>(&header), sizeof(header));
+
+        const std::uint64_t tiles_x = (header.width + tile_size - 1) / tile_size;
+        const std::uint64_t tiles_y = (header.height + tile_size - 1) / tile_size;
+        std::vector<Cell> tile(static_cast<std::size_t>(tile_size) * tile_size);
+        std::vector<std::uint8_t> bytes(tile.size());
+        for (std::uint64_t tile_y = 0; tile_y < tiles_y; ++tile_y)
+        {
+            for (std::uint64_t tile_x = 0; tile_x < tiles_x; ++tile_x)
+            {
+                std::fill(tile.begin(), tile.end(), Cell::Space);
+                fill(tile_x, tile_y, tile);
+                for (std::size_t i = 0; i < tile.size(); ++i)
+                {
+                    bytes[i] = static_cast<std::uint8_t>(tile[i]);
+                }
+                write(bytes.data(), bytes.size());
+            }
+        }
+    }
+
+    /// @brief Fill tiles from an in-memory grid
+    static TileFiller grid_filler(const Grid &grid, std::uint32_t tile_size)
+    {
+        const Coord size = tile_size;
+        return [&grid, size](std::uint64_t tile_x, std::uint64_t tile_y, std::span<Cell> cells)
+        {
+            for (Coord y = 0; y < size; ++y)
+            {
+                for (Coord x = 0; x < size; ++x)
+                {
+                    auto cell = grid.at(static_cast<Coord>(tile_x) * size + x, static_cast<Coord>(tile_y) * size + y);
+                    if (cell)
+                    {
+                        cells[static_cast<std::size_t>(y * size + x)] = *cell;
+                    }
+                }
+            }
+        };
+    }
+
+    void write_tile_file(const std::string &path, Coord width, Coord height, std::uint32_t tile_size, const TileFiller &fill)
+    {
+        tile_image_size(width, height, tile_size);
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            throw std::runtime_error("unable to create tile file " + path);
+        }
+        emit_tile_image(width, height, tile_size, fill, [&](const std::uint8_t *bytes, std::size_t count)
+                        { file.write(reinterpret_cast<const char *>(bytes), static_cast<std::streamsize>(count)); });
+        if (!file)
+        {
+            throw std::runtime_error("unable to write tile file " + path);
+        }
+    }
+
+    void write_tile_image(std::span<std::uint8_t> out, const Grid &grid, std::uint32_t tile_size)
+    {
+        if (out.size() < tile_image_size(grid.width(), grid.height(), tile_size))
+        {
+            throw std::runtime_error("tile image does not fit");
+        }
+        auto *at = out.data();
+        emit_tile_image(grid.width(), grid.height(), tile_size, grid_filler(grid, tile_size), [&](const std::uint8_t *bytes, std::size_t count)
+                        {
+            std::memcpy(at, bytes, count);
+            at += count; });
+    }
+
+    void write_tile_file(const std::string &path, const Grid &grid, std::uint32_t tile_size)
+    {
+        write_tile_file(path, grid.width(), grid.height(), tile_size, grid_filler(grid, tile_size));
+    }
+
+    MappedGrid::MappedGrid(const std::string &path)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw std::runtime_error("unable to open tile file " + path);
+        }
+        try
+        {
+            map(fd, 0, path);
+        }
+        catch (...)
+        {
+            ::close(fd);
+            throw;
+        }
+        ::close(fd);
+    }
+
+    MappedGrid::MappedGrid(int fd, std::size_t offset, const std::string &name)
+    {
+        map(fd, offset, name);
+    }
+
+    void MappedGrid::map(int fd, std::size_t offset, const std::string &path)
+    {
+        struct stat info;
+        if (::fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < offset + sizeof(TileFileHeader))
+        {
+            throw std::runtime_error("tile file too small " + path);
+        }
+        mapping_size_ = static_cast<std::size_t>(info.st_size) - offset;
+        mapping_ = ::mmap(nullptr, mapping_size_, PROT_READ, MAP_SHARED, fd, static_cast<off_t>(offset));
+        if (mapping_ == MAP_FAILED)
+        {
+            mapping_ = nullptr;
+            throw std::runtime_error("unable to map tile file " + path);
+        }
+
+        TileFileHeader header;
+        std::memcpy(&header, mapping_, sizeof(header));
+        tile_size_ = header.tile_size;
+        if (std::memcmp(header.magic, tile_file_magic, sizeof(header.magic)) != 0 || tile_size_ == 0 ||
+            !std::has_single_bit(tile_size_) || header.width > static_cast<std::uint64_t>(std::numeric_limits<Coord>::max()) ||
+            header.height > static_cast<std::uint64_t>(std::numeric_limits<Coord>::max()))
+        {
+            ::munmap(mapping_, mapping_size_);
+            mapping_ = nullptr;
+            throw std::runtime_error("not a tile file " + path);
+        }
+        width_ = static_cast<Coord>(header.width);
+        height_ = static_cast<Coord>(header.height);
+        tile_shift_ = static_cast<unsigned>(std::countr_zero(tile_size_));
+        tiles_x_ = (header.width + tile_size_ - 1) / tile_size_;
+        tiles_y_ = (header.height + tile_size_ - 1) / tile_size_;
+        // A crafted header must not wrap the size check below around to a small number
+        std::uint64_t tiles = 0;
+        std::uint64_t file_size = 0;
+        if (__builtin_mul_overflow(tiles_x_, tiles_y_, &tiles) ||
+            __builtin_mul_overflow(tiles, tile_size_ * tile_size_, &padded_cells_) ||
+            __builtin_add_overflow(padded_cells_, sizeof(header), &file_size) ||
+            mapping_size_ < file_size)
+        {
+            ::munmap(mapping_, mapping_size_);
+            mapping_ = nullptr;
+            throw std::runtime_error("truncated tile file " + path);
+        }
+        cells_ = static_cast<const std::uint8_t *>(mapping_) + sizeof(header);
+    }
+
+    MappedGrid::MappedGrid(MappedGrid &&other) noexcept
+        : width_(other.width_), height_(other.height_), tile_size_(other.tile_size_), tile_shift_(other.tile_shift_),
+          tiles_x_(other.tiles_x_), tiles_y_(other.tiles_y_), padded_cells_(other.padded_cells_), mapping_(other.mapping_),
+          mapping_size_(other.mapping_size_), cells_(other.cells_)
+    {
+        other.mapping_ = nullptr;
+        other.cells_ = nullptr;
+    }
+
+    MappedGrid::~MappedGrid()
+    {
+        if (mapping_)
+        {
+            ::munmap(mapping_, mapping_size_);
+        }
+    }
+
+    namespace
+    {
+        /// Four visited direction bits per cell, in a lazily committed anonymous
+        /// mapping so untouched pages cost nothing and dirty pages can be swapped out.
+        class ScratchNibbles
+        {
+        public:
+            explicit ScratchNibbles(std::uint64_t cells) : size((cells + 1) / 2)
+            {
+                auto mapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+                if (mapping == MAP_FAILED)
+                {
+                    throw std::runtime_error("unable to map trace scratch space");
+                }
+                bytes = static_cast<std::uint8_t *>(mapping);
+            }
+            ScratchNibbles(const ScratchNibbles &) = delete;
+            ScratchNibbles &operator=(const ScratchNibbles &) = delete;
+            ~ScratchNibbles()
+            {
+                release();
+            }
+
+            /// Same contract as OccupyGrid::visit, keeping the occupied count as it goes
+            bool visit(std::uint64_t index, Direction direction)
+            {
+                auto &byte = bytes[index >> 1];
+                const unsigned shift = (index & 1) * 4;
+                const auto bit = static_cast<std::uint8_t>(1u << (static_cast<unsigned>(direction) + shift));
+                if (byte & bit)
+                {
+                    return false;
+                }
+                if (((byte >> shift) & 0xf) == 0)
+                {
+                    occupied++;
+                }
+                byte |= bit;
+                return true;
+            }
+
+            std::size_t occupied = 0;
+
+        private:
+            void release()
+            {
+                if (bytes)
+                {
+                    ::munmap(bytes, size);
+                    bytes = nullptr;
+                }
+            }
+
+            std::size_t size;
+            std::uint8_t *bytes = nullptr;
+        };
+
+        template <typename Index>
+        std::size_t trace_tiled(const MappedGrid &grid, const XY &entry_location, const Direction &entry_direction)
+        {
+            auto [entry_x, entry_y] = entry_location;
+            if (!grid.at(entry_x, entry_y))
+            {
+                return 0;
+            }
+            const auto width = static_cast<Index>(grid.width());
+            const auto height = static_cast<Index>(grid.height());
+            ScratchNibbles visited(grid.padded_cells());
+            std::vector<BeamAt<Index>> beams = {{static_cast<Index>(entry_x), static_cast<Index>(entry_y), entry_direction}};
+            walk_beams(beams, beams, width, height, [&](Index x, Index y, Direction direction) -> std::optional<Cell>
+                       {
+                auto index = grid.cell_index<Index>(x, y);
+                if (!visited.visit(index, direction))
+                {
+                    return std::nullopt;
+                }
+                return grid.cell(index); });
+            return visited.occupied;
+        }
+    }
+
+    std::size_t trace_grid(const MappedGrid &grid, const XY &entry_location, const Direction &entry_direction)
+    {
+        constexpr std::uint64_t compact_limit = std::numeric_limits<std::uint32_t>::max();
+        if (grid.padded_cells() <= compact_limit)
+        {
+            return trace_tiled<std::uint32_t>(grid, entry_location, entry_direction);
+        }
+        return trace_tiled<std::uint64_t>(grid, entry_location, entry_direction);
+    }
+}
@@ -0,0 +1,134 @@
+#include "model_batch.h"
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace clarity
+{
+    // Bit i set when power[i] is non-zero, for 64 models
+    static std::uint64_t nonzero_mask(const std::uint8_t *power)
+    {
+        std::uint64_t mask = 0;
+#if defined(__SSE2__)
+        const auto zero = _mm_setzero_si128();
+        for (int chunk = 0; chunk < 4; ++chunk)
+        {
+            auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(power + chunk * 16));
+            auto zeros = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, zero)));
+            mask |= static_cast<std::uint64_t>(~zeros & 0xffff) << (chunk * 16);
+        }
+#else
+        for (int i = 0; i < 64; ++i)
+        {
+            mask |= static_cast<std::uint64_t>(power[i] != 0) << i;
+        }
+#endif
+        return mask;
+    }
+
+    // Bit i set when values[i] is non-zero, for 64 models
+    static std::uint64_t nonzero_mask(const int *values)
+    {
+        std::uint64_t zeros = 0;
+#if defined(__AVX2__)
+        const auto zero = _mm256_setzero_si256();
+        for (int chunk = 0; chunk < 8; ++chunk)
+        {
+            auto lanes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values + chunk * 8));
+            auto equal = _mm256_castsi256_ps(_mm256_cmpeq_epi32(lanes, zero));
+            zeros |= static_cast<std::uint64_t>(_mm256_movemask_ps(equal)) << (chunk * 8);
+        }
+#elif defined(__SSE2__)
+        const auto zero = _mm_setzero_si128();
+        for (int chunk = 0; chunk < 16; ++chunk)
+        {
+            auto lanes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(values + chunk * 4));
+            auto equal = _mm_castsi128_ps(_mm_cmpeq_epi32(lanes, zero));
+            zeros |= static_cast<std::uint64_t>(_mm_movemask_ps(equal)) << (chunk * 4);
+        }
+#else
+        for (int i = 0; i < 64; ++i)
+        {
+            zeros |= static_cast<std::uint64_t>(values[i] == 0) << i;
+        }
+#endif
+        return ~zeros;
+    }
+
+    ModelBatch::ModelBatch(std::size_t other_value_count) : field_count_(state_count + other_value_count) {}
+
+    std::size_t ModelBatch::add()
+    {
+        if (size_ == capacity_)
+        {
+            grow();
+        }
+        return size_++;
+    }
+
+    void ModelBatch::grow()
+    {
+        auto capacity = std::max<std::size_t>(64, capacity_ * 2);
+        std::vector<int> values(field_count_ * capacity, 0);
+        for (std::size_t field = 0; field < field_count_; ++field)
+        {
+            std::copy(column(field), column(field) + capacity_, values.begin() + field * capacity);
+        }
+        values_ = std::move(values);
+        power_.resize(capacity, 0);
+        capacity_ = capacity;
+    }
+
+    void ModelBatch::setStates(std::size_t model, int value)
+    {
+        for (std::size_t field = 0; field < state_count; ++field)
+        {
+            column(field)[model] = value;
+        }
+    }
+
+    void ModelBatch::setOtherValues(std::size_t model, int value)
+    {
+        for (std::size_t field = state_count; field < field_count_; ++field)
+        {
+            column(field)[model] = value;
+        }
+    }
+
+    bool ModelBatch::isValid(std::size_t model) const
+    {
+        if (!power_[model])
+        {
+            return false;
+        }
+        for (std::size_t field = 0; field < field_count_; ++field)
+        {
+            if (column(field)[model] == 0)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    ValidityBitmap ModelBatch::validate() const
+    {
+        ValidityBitmap bitmap(capacity_ / 64);
+        for (std::size_t word = 0; word < bitmap.size(); ++word)
+        {
+            const auto first = word * 64;
+            auto valid = nonzero_mask(power_.data() + first);
+            // Stop reading columns once every model in the word has failed
+            for (std::size_t field = 0; field < field_count_ && valid != 0; ++field)
+            {
+                valid &= nonzero_mask(column(field) + first);
+            }
+            bitmap[word] = valid;
+        }
+        return bitmap;
+    }
+}
@@ -0,0 +1,268 @@
+#include "multi_trace.h"
+#include <array>
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+
+namespace cells
+{
+    std::vector<Entry> edge_entries(Coord width, Coord height)
+    {
+        std::vector<Entry> entries;
+        if (width <= 0 || height <= 0)
+        {
+            return entries;
+        }
+        entries.reserve(static_cast<std::size_t>(2 * (width + height)));
+        for (Coord x = 0; x < width; ++x)
+        {
+            entries.push_back({{x, 0}, Direction::Down});
+            entries.push_back({{x, height - 1}, Direction::Up});
+        }
+        for (Coord y = 0; y < height; ++y)
+        {
+            entries.push_back({{0, y}, Direction::Right});
+            entries.push_back({{width - 1, y}, Direction::Left});
+        }
+        return entries;
+    }
+
+    namespace
+    {
+        /// One bit per query, Words * 64 queries wide.  Plain loops the
+        /// compiler turns into vector instructions when they are available.
+        template <std::size_t Words>
+        struct LaneMask
+        {
+            std::array<std::uint64_t, Words> words{};
+
+            bool any() const
+            {
+                std::uint64_t bits = 0;
+                for (auto word : words)
+                {
+                    bits |= word;
+                }
+                return bits != 0;
+            }
+            LaneMask &operator|=(const LaneMask &other)
+            {
+                for (std::size_t i = 0; i < Words; ++i)
+                {
+                    words[i] |= other.words[i];
+                }
+                return *this;
+            }
+            /// this & ~other
+            LaneMask without(const LaneMask &other) const
+            {
+                LaneMask result;
+                for (std::size_t i = 0; i < Words; ++i)
+                {
+                    result.words[i] = words[i] & ~other.words[i];
+                }
+                return result;
+            }
+        };
+
+        /// Per lane counters stored as bit planes, plane k holds bit k of every lane's count
+        template <std::size_t Words>
+        class LaneCounter
+        {
+        public:
+            void add(LaneMask<Words> carry)
+            {
+                for (auto &plane : planes)
+                {
+                    if (!carry.any())
+                    {
+                        return;
+                    }
+                    for (std::size_t i = 0; i < Words; ++i)
+                    {
+                        auto overflow = plane.words[i] & carry.words[i];
+                        plane.words[i] ^= carry.words[i];
+                        carry.words[i] = overflow;
+                    }
+                }
+            }
+            std::size_t count(std::size_t lane) const
+            {
+                std::size_t total = 0;
+                for (std::size_t k = 0; k < planes.size(); ++k)
+                {
+                    total |= static_cast<std::size_t>((planes[k].words[lane / 64] >> (lane % 64)) & 1) << k;
+                }
+                return total;
+            }
+
+        private:
+            std::array<LaneMask<Words>, 48> planes{};
+        };
+
+        template <std::size_t Words>
+        void trace_pass(const std::vector<Cell> &cells, Coord width, Coord height, std::span<const Entry> entries, std::span<std::size_t> results)
+        {
+            using Mask = LaneMask<Words>;
+            const auto size = static_cast<std::size_t>(width * height);
+            // Indexed by direction * size + cell, one plane per direction so a
+            // sweep reads consecutive masks.  incoming holds bits turned into a
+            // slot by a mirror or splitter that its sweep has not consumed yet.
+            std::vector<Mask> reached(size * 4);
+            std::vector<Mask> incoming(size * 4);
+            auto slot_of = [width, size](Coord x, Coord y, Direction direction)
+            { return static_cast<std::size_t>(direction) * size + static_cast<std::size_t>(y * width + x); };
+            // Whether row y has anything in incoming for a direction, rows without can be skipped
+            std::vector<std::uint8_t> row_incoming(static_cast<std::size_t>(height) * 4, 0);
+            auto mark_row = [&row_incoming](Coord y, Direction direction)
+            { row_incoming[static_cast<std::size_t>(y) * 4 + static_cast<std::size_t>(direction)] = 1; };
+            auto take_row = [&row_incoming](Coord y, Direction direction)
+            { return std::exchange(row_incoming[static_cast<std::size_t>(y) * 4 + static_cast<std::size_t>(direction)], 0) != 0; };
+
+            for (std::size_t lane = 0; lane < entries.size(); ++lane)
+            {
+                auto [x, y] = entries[lane].location;
+                if (x >= 0 && y >= 0 && x < width && y < height)
+                {
+                    incoming[slot_of(x, y, entries[lane].direction)].words[lane / 64] |= std::uint64_t(1) << (lane % 64);
+                    mark_row(y, entries[lane].direction);
+                }
+            }
+
+            // Bits new to (x, y, direction) are recorded, then either carried on
+            // straight or handed to the turned slots.  Returns what keeps going straight.
+            bool changed = true;
+            auto step = [&](Coord x, Coord y, Direction direction, Mask carry) -> Mask
+            {
+                auto slot = slot_of(x, y, direction);
+                carry |= incoming[slot];
+                incoming[slot] = {};
+                auto arriving = carry.without(reached[slot]);
+                if (!arriving.any())
+                {
+                    return arriving;
+                }
+                changed = true;
+                reached[slot] |= arriving;
+                const auto &next = exits(cells[static_cast<std::size_t>(y * width + x)], direction);
+                if (next.count == 1 && next.directions[0] == direction)
+                {
+                    return arriving;
+                }
+                for (std::size_t i = 0; i < next.count; ++i)
+                {
+                    auto [dx, dy] = delta(next.directions[i]);
+                    if (x + dx >= 0 && y + dy >= 0 && x + dx < width && y + dy < height)
+                    {
+                        incoming[slot_of(x + dx, y + dy, next.directions[i])] |= arriving;
+                        mark_row(y + dy, next.directions[i]);
+                    }
+                }
+                return {};
+            };
+
+            // Sweep each direction in its travel order so a straight run is
+            // carried across the whole line in one pass, until a round of four
+            // sweeps finds nothing new.  Vertical sweeps go row by row with a
+            // carry per column to stay in memory order.
+            std::vector<Mask> columns(static_cast<std::size_t>(width));
+            auto vertical_sweep = [&](Coord y, Direction direction, bool &carrying)
+            {
+                if (!take_row(y, direction) && !carrying)
+                {
+                    return;
+                }
+                carrying = false;
+                for (Coord x = 0; x < width; ++x)
+                {
+                    columns[x] = step(x, y, direction, columns[x]);
+                    carrying |= columns[x].any();
+                }
+            };
+            while (changed)
+            {
+                changed = false;
+                for (Coord y = 0; y < height; ++y)
+                {
+                    if (!take_row(y, Direction::Right))
+                    {
+                        continue;
+                    }
+                    Mask carry{};
+                    for (Coord x = 0; x < width; ++x)
+                    {
+                        carry = step(x, y, Direction::Right, carry);
+                    }
+                }
+                std::fill(columns.begin(), columns.end(), Mask{});
+                bool carrying = false;
+                for (Coord y = 0; y < height; ++y)
+                {
+                    vertical_sweep(y, Direction::Down, carrying);
+                }
+                for (Coord y = 0; y < height; ++y)
+                {
+                    if (!take_row(y, Direction::Left))
+                    {
+                        continue;
+                    }
+                    Mask carry{};
+                    for (Coord x = width - 1; x >= 0; --x)
+                    {
+                        carry = step(x, y, Direction::Left, carry);
+                    }
+                }
+                std::fill(columns.begin(), columns.end(), Mask{});
+                carrying = false;
+                for (Coord y = height - 1; y >= 0; --y)
+                {
+                    vertical_sweep(y, Direction::Up, carrying);
+                }
+            }
+
+            LaneCounter<Words> counter;
+            for (std::size_t cell = 0; cell < size; ++cell)
+            {
+                auto energized = reached[cell];
+                energized |= reached[size + cell];
+                energized |= reached[2 * size + cell];
+                energized |= reached[3 * size + cell];
+                counter.add(energized);
+            }
+            for (std::size_t lane = 0; lane < entries.size(); ++lane)
+            {
+                results[lane] = counter.count(lane);
+            }
+        }
+
+        template <std::size_t Words>
+        void trace_passes(const Grid &grid, std::span<const Entry> entries, std::span<std::size_t> results)
+        {
+            const auto cells = flatten(grid);
+            constexpr std::size_t lanes = Words * 64;
+            for (std::size_t first = 0; first < entries.size(); first += lanes)
+            {
+                auto count = std::min(lanes, entries.size() - first);
+                trace_pass<Words>(cells, grid.width(), grid.height(), entries.subspan(first, count), results.subspan(first, count));
+            }
+        }
+    }
+
+    std::vector<std::size_t> trace_entries(const Grid &grid, std::span<const Entry> entries, std::size_t lanes)
+    {
+        std::vector<std::size_t> results(entries.size(), 0);
+        switch (lanes)
+        {
+        case 64:
+            trace_passes<1>(grid, entries, results);
+            break;
+        case 256:
+            trace_passes<4>(grid, entries, results);
+            break;
+        default:
+            throw std::runtime_error("trace lanes must be 64 or 256");
+        }
+        return results;
+    }
+}
@@ -0,0 +1,71 @@
+#include "output_buffer.h"
+#include <chrono>
+
+namespace state_machine
+{
+    static void spin_for(double seconds)
+    {
+        if (seconds <= 0.0)
+        {
+            return;
+        }
+        auto end = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+        while (std::chrono::steady_clock::now() < end)
+        {
+        }
+    }
+
+    void SimulatedBus::write(const OutputWrite *writes, std::size_t count)
+    {
+        transactions++;
+        this->writes += count;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (writes[i].channel >= values.size())
+            {
+                values.resize(writes[i].channel + 1, OnOff::Off);
+            }
+            values[writes[i].channel] = writes[i].value;
+        }
+        spin_for(transaction_seconds + write_seconds * count);
+    }
+
+    ChannelId OutputBuffer::add_channel()
+    {
+        channels_.emplace_back();
+        return channels_.size() - 1;
+    }
+
+    void OutputBuffer::set(ChannelId channel, OnOff value)
+    {
+        auto &state = channels_[channel];
+        state.pending = value;
+        if (!state.dirty && value != state.committed)
+        {
+            state.dirty = true;
+            dirty_.push_back(channel);
+        }
+    }
+
+    std::size_t OutputBuffer::flush()
+    {
+        writes_.clear();
+        for (auto channel : dirty_)
+        {
+            auto &state = channels_[channel];
+            state.dirty = false;
+            // A channel set and then set back within the frame has nothing to send
+            if (state.pending != state.committed)
+            {
+                state.committed = state.pending;
+                writes_.push_back({channel, state.pending});
+            }
+        }
+        dirty_.clear();
+        if (!writes_.empty())
+        {
+            bus.write(writes_.data(), writes_.size());
+        }
+        return writes_.size();
+    }
+}
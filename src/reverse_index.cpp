@@ -0,0 +1,75 @@
+#include "reverse_index.h"
+
+namespace cells
+{
+    ReverseBeamIndex::ReverseBeamIndex(const Grid &grid)
+        : width_(grid.width()), height_(grid.height()), entries_(edge_entries(grid.width(), grid.height()))
+    {
+        const auto size = static_cast<std::size_t>(width_ * height_);
+        cells_ = flatten(grid);
+        entry_of_state_.assign(size * 4, no_entry);
+        for (std::size_t i = 0; i < entries_.size(); ++i)
+        {
+            auto [x, y] = entries_[i].location;
+            entry_of_state_[static_cast<std::size_t>(y * width_ + x) * 4 + static_cast<std::size_t>(entries_[i].direction)] = static_cast<std::uint32_t>(i);
+        }
+        for (std::size_t cell = 0; cell < 5; ++cell)
+        {
+            for (std::size_t entry = 0; entry < 4; ++entry)
+            {
+                const auto &next = exits(static_cast<Cell>(cell), static_cast<Direction>(entry));
+                for (std::size_t i = 0; i < next.count; ++i)
+                {
+                    entering_[cell][static_cast<std::size_t>(next.directions[i])].push_back(static_cast<Direction>(entry));
+                }
+            }
+        }
+    }
+
+    EntryBitmap ReverseBeamIndex::entries_reaching(Coord x, Coord y) const
+    {
+        EntryBitmap result(entries_.size());
+        if (x < 0 || y < 0 || x >= width_ || y >= height_)
+        {
+            return result;
+        }
+        std::vector<bool> seen(cells_.size() * 4, false);
+        std::vector<std::size_t> states;
+        for (std::size_t direction = 0; direction < 4; ++direction)
+        {
+            auto state = static_cast<std::size_t>(y * width_ + x) * 4 + direction;
+            seen[state] = true;
+            states.push_back(state);
+        }
+        while (!states.empty())
+        {
+            auto state = states.back();
+            states.pop_back();
+            if (entry_of_state_[state] != no_entry)
+            {
+                result.set(entry_of_state_[state]);
+            }
+            // Entering `cell` heading `direction` means leaving the cell behind it that way
+            const auto cell = static_cast<Coord>(state / 4);
+            const auto direction = static_cast<Direction>(state % 4);
+            auto [dx, dy] = delta(direction);
+            const auto from_x = cell % width_ - dx;
+            const auto from_y = cell / width_ - dy;
+            if (from_x < 0 || from_y < 0 || from_x >= width_ || from_y >= height_)
+            {
+                continue;
+            }
+            const auto from = static_cast<std::size_t>(from_y * width_ + from_x);
+            for (auto entry : entering_[static_cast<std::size_t>(cells_[from])][static_cast<std::size_t>(direction)])
+            {
+                auto previous = from * 4 + static_cast<std::size_t>(entry);
+                if (!seen[previous])
+                {
+                    seen[previous] = true;
+                    states.push_back(previous);
+                }
+            }
+        }
+        return result;
+    }
+}
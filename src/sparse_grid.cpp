@@ -0,0 +1,341 @@
+#include "sparse_grid.h"
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
+namespace cells
+{
+    SparseGrid::SparseGrid(Coord width, Coord height, std::vector<Obstacle> obstacles)
+        : width_(width), height_(height), obstacles_(std::move(obstacles))
+    {
+        std::erase_if(obstacles_, [](const Obstacle &obstacle)
+                      { return obstacle.cell == Cell::Space; });
+        for (const auto &obstacle : obstacles_)
+        {
+            if (obstacle.x < 0 || obstacle.y < 0 || obstacle.x >= width_ || obstacle.y >= height_)
+            {
+                throw std::runtime_error("obstacle outside of sparse grid");
+            }
+        }
+        std::sort(obstacles_.begin(), obstacles_.end(), [](const Obstacle &a, const Obstacle &b)
+                  { return std::tie(a.y, a.x) < std::tie(b.y, b.x); });
+
+        // Counting sort into rows and columns
+        row_offsets_.assign(height_ + 1, 0);
+        column_offsets_.assign(width_ + 1, 0);
+        for (const auto &obstacle : obstacles_)
+        {
+            row_offsets_[obstacle.y + 1]++;
+            column_offsets_[obstacle.x + 1]++;
+        }
+        for (Coord y = 0; y < height_; ++y)
+        {
+            row_offsets_[y + 1] += row_offsets_[y];
+        }
+        for (Coord x = 0; x < width_; ++x)
+        {
+            column_offsets_[x + 1] += column_offsets_[x];
+        }
+
+        // Obstacles are visited in row-major order, so each column fills in y order
+        column_entries_.resize(obstacles_.size());
+        auto next_in_column = column_offsets_;
+        for (std::size_t id = 0; id < obstacles_.size(); ++id)
+        {
+            column_entries_[next_in_column[obstacles_[id].x]++] = id;
+        }
+    }
+
+    static std::vector<SparseGrid::Obstacle> grid_obstacles(const Grid &grid)
+    {
+        std::vector<SparseGrid::Obstacle> obstacles;
+        for (Coord y = 0; y < grid.height(); ++y)
+        {
+            for (Coord x = 0; x < grid.width(); ++x)
+            {
+                auto cell = grid.at(x, y).value();
+                if (cell != Cell::Space)
+                {
+                    obstacles.push_back({x, y, cell});
+                }
+            }
+        }
+        return obstacles;
+    }
+
+    SparseGrid::SparseGrid(const Grid &grid) : SparseGrid(grid.width(), grid.height(), grid_obstacles(grid)) {}
+
+    std::optional<Cell> SparseGrid::at(Coord x, Coord y) const
+    {
+        if (x < 0 || y < 0 || x >= width_ || y >= height_)
+        {
+            return std::nullopt;
+        }
+        auto begin = obstacles_.begin() + row_offsets_[y];
+        auto end = obstacles_.begin() + row_offsets_[y + 1];
+        auto found = std::lower_bound(begin, end, x, [](const Obstacle &obstacle, Coord x)
+                                      { return obstacle.x < x; });
+        if (found != end && found->x == x)
+        {
+            return found->cell;
+        }
+        return Cell::Space;
+    }
+
+    std::optional<std::size_t> SparseGrid::next_obstacle(const XY &location, const Direction &direction) const
+    {
+        auto [x, y] = location;
+        if (x < 0 || y < 0 || x >= width_ || y >= height_)
+        {
+            return std::nullopt;
+        }
+        switch (direction)
+        {
+        case Direction::Right:
+        case Direction::Left:
+        {
+            auto begin = obstacles_.begin() + row_offsets_[y];
+            auto end = obstacles_.begin() + row_offsets_[y + 1];
+            auto by_x = [](const Obstacle &obstacle, Coord x)
+            { return obstacle.x < x; };
+            if (direction == Direction::Right)
+            {
+                auto found = std::lower_bound(begin, end, x, by_x);
+                if (found == end)
+                {
+                    return std::nullopt;
+                }
+                return found - obstacles_.begin();
+            }
+            // Last obstacle with obstacle.x <= x
+            auto found = std::lower_bound(begin, end, x + 1, by_x);
+            if (found == begin)
+            {
+                return std::nullopt;
+            }
+            return (found - 1) - obstacles_.begin();
+        }
+        case Direction::Down:
+        case Direction::Up:
+        {
+            auto begin = column_entries_.begin() + column_offsets_[x];
+            auto end = column_entries_.begin() + column_offsets_[x + 1];
+            auto by_y = [this](std::size_t id, Coord y)
+            { return obstacles_[id].y < y; };
+            if (direction == Direction::Down)
+            {
+                auto found = std::lower_bound(begin, end, y, by_y);
+                if (found == end)
+                {
+                    return std::nullopt;
+                }
+                return *found;
+            }
+            auto found = std::lower_bound(begin, end, y + 1, by_y);
+            if (found == begin)
+            {
+                return std::nullopt;
+            }
+            return *(found - 1);
+        }
+        }
+        throw std::runtime_error("untested direction");
+    }
+
+    namespace
+    {
+        /// Straight run of energized cells, from <= to, along row `line` (horizontal) or column `line`
+        struct Segment
+        {
+            Coord line;
+            Coord from;
+            Coord to;
+        };
+
+        /// Sorts and merges overlapping segments on the same line, returns the total length
+        std::size_t merge_segments(std::vector<Segment> &segments)
+        {
+            std::sort(segments.begin(), segments.end(), [](const Segment &a, const Segment &b)
+                      { return std::tie(a.line, a.from) < std::tie(b.line, b.from); });
+            std::size_t merged = 0;
+            for (const auto &segment : segments)
+            {
+                if (merged > 0 && segments[merged - 1].line == segment.line && segment.from <= segments[merged - 1].to)
+                {
+                    segments[merged - 1].to = std::max(segments[merged - 1].to, segment.to);
+                    continue;
+                }
+                segments[merged++] = segment;
+            }
+            segments.resize(merged);
+
+            std::size_t length = 0;
+            for (const auto &segment : segments)
+            {
+                length += static_cast<std::size_t>(segment.to - segment.from + 1);
+            }
+            return length;
+        }
+
+        class Fenwick
+        {
+        public:
+            explicit Fenwick(std::size_t size) : tree(size + 1, 0) {}
+            void add(std::size_t index, Coord delta)
+            {
+                for (++index; index < tree.size(); index += index & (~index + 1))
+                {
+                    tree[index] += delta;
+                }
+            }
+            // Sum of [0, end)
+            Coord prefix(std::size_t end) const
+            {
+                Coord sum = 0;
+                for (; end > 0; end -= end & (~end + 1))
+                {
+                    sum += tree[end];
+                }
+                return sum;
+            }
+
+        private:
+            std::vector<Coord> tree;
+        };
+
+        /// Number of cells covered by both a horizontal and a vertical segment.
+        /// Sweeps rows top to bottom keeping the active vertical segments in a Fenwick
+        /// tree over their compressed x coordinates.
+        std::size_t crossings(const std::vector<Segment> &horizontal, const std::vector<Segment> &vertical)
+        {
+            if (horizontal.empty() || vertical.empty())
+            {
+                return 0;
+            }
+            std::vector<Coord> xs;
+            for (const auto &segment : vertical)
+            {
+                xs.push_back(segment.line);
+            }
+            std::sort(xs.begin(), xs.end());
+            xs.erase(std::unique(xs.begin(), xs.end()), xs.end());
+            auto x_index = [&xs](Coord x)
+            { return static_cast<std::size_t>(std::lower_bound(xs.begin(), xs.end(), x) - xs.begin()); };
+
+            struct Event
+            {
+                Coord y;
+                // Updates sort before queries on the same row
+                int kind;
+                Coord a;
+                Coord b;
+            };
+            std::vector<Event> events;
+            events.reserve(vertical.size() * 2 + horizontal.size());
+            for (const auto &segment : vertical)
+            {
+                events.push_back({segment.from, 0, segment.line, 1});
+                events.push_back({segment.to + 1, 0, segment.line, -1});
+            }
+            for (const auto &segment : horizontal)
+            {
+                events.push_back({segment.line, 1, segment.from, segment.to});
+            }
+            std::sort(events.begin(), events.end(), [](const Event &a, const Event &b)
+                      { return std::tie(a.y, a.kind) < std::tie(b.y, b.kind); });
+
+            Fenwick active(xs.size());
+            std::size_t count = 0;
+            for (const auto &event : events)
+            {
+                if (event.kind == 0)
+                {
+                    active.add(x_index(event.a), event.b);
+                }
+                else
+                {
+                    auto first = x_index(event.a);
+                    auto last = x_index(event.b + 1);
+                    count += static_cast<std::size_t>(active.prefix(last) - active.prefix(first));
+                }
+            }
+            return count;
+        }
+    }
+
+    std::size_t trace_grid(const SparseGrid &grid, const XY &entry_location, const Direction &entry_direction)
+    {
+        std::vector<Beam> beams = {Beam(entry_location, entry_direction)};
+        // One bit per direction for every obstacle
+        std::vector<std::uint8_t> visited(grid.obstacle_count(), 0);
+        std::vector<Segment> horizontal;
+        std::vector<Segment> vertical;
+
+        while (!beams.empty())
+        {
+            auto beam = beams.back();
+            beams.pop_back();
+
+            auto [x, y] = beam.location;
+            if (x < 0 || y < 0 || x >= grid.width() || y >= grid.height())
+            {
+                // We've gone off the grid
+                continue;
+            }
+
+            // Walk straight to the next obstacle, or the edge of the grid
+            auto hit = grid.next_obstacle(beam.location, beam.direction);
+            Coord end_x = x;
+            Coord end_y = y;
+            if (hit)
+            {
+                end_x = grid.obstacle(*hit).x;
+                end_y = grid.obstacle(*hit).y;
+            }
+            else
+            {
+                switch (beam.direction)
+                {
+                case Direction::Up:
+                    end_y = 0;
+                    break;
+                case Direction::Down:
+                    end_y = grid.height() - 1;
+                    break;
+                case Direction::Left:
+                    end_x = 0;
+                    break;
+                case Direction::Right:
+                    end_x = grid.width() - 1;
+                    break;
+                }
+            }
+            if (beam.direction == Direction::Left || beam.direction == Direction::Right)
+            {
+                horizontal.push_back({y, std::min(x, end_x), std::max(x, end_x)});
+            }
+            else
+            {
+                vertical.push_back({x, std::min(y, end_y), std::max(y, end_y)});
+            }
+            if (!hit)
+            {
+                continue;
+            }
+
+            auto bit = static_cast<std::uint8_t>(1 << static_cast<int>(beam.direction));
+            if (visited[*hit] & bit)
+            {
+                continue;
+            }
+            visited[*hit] |= bit;
+
+            const auto &obstacle = grid.obstacle(*hit);
+            auto next_possible = next_possible_beams(obstacle.cell, beam.direction, XY{obstacle.x, obstacle.y});
+            beams.insert(beams.end(), next_possible.begin(), next_possible.end());
+        }
+
+        auto total = merge_segments(horizontal) + merge_segments(vertical);
+        return total - crossings(horizontal, vertical);
+    }
+}
@@ -0,0 +1,70 @@
+#include "state_machine.h"
+
+namespace state_machine
+{
+    OnOff toggle(OnOff value)
+    {
+        return (value == OnOff::On) ? OnOff::Off : OnOff::On;
+    }
+
+    /// Busy-waits on the two options.  Returns RELEASED if button released, ITimer if ITimer expired
+    FlashResult button_released_or_timer_expired(IIO &io, ITimer &timer)
+    {
+        while (true)
+        {
+            if (io.button_released())
+            {
+                return FlashResult::Released;
+            }
+            if (timer.expired())
+            {
+                return FlashResult::Timer;
+            }
+        }
+    }
+
+    void flash_until_button_released(IIO &io, ITimer &timer)
+    {
+        // Setup our initial state of the light being on and the timer being reset
+        // Keep track of whether the light is on or off
+        OnOff light_state = OnOff::On;
+        // Turn the light on
+        io.set_light(light_state);
+        // Reset the timer so we get a full blink
+        timer.reset(1.0);
+
+        // Loop until the button is released or the timer expires
+        // Keep looping if the thing that happened was the timer expiring.
+        while (FlashResult::Timer == button_released_or_timer_expired(io, timer))
+        {
+            // Inside the loop the timer expired. Reset timer, flip the light state, and set the light
+            timer.reset(1.0);
+            light_state = toggle(light_state);
+            io.set_light(light_state);
+        }
+
+        // Before we exit, turn the light back off.
+        io.set_light(OnOff::Off);
+    }
+
+    void wait_until_button_pressed(IIO &io)
+    {
+        while (true)
+        {
+            if (io.button_pressed())
+            {
+                break;
+            }
+        }
+    }
+
+    void start(IIO &io, ITimer &timer)
+    {
+        io.set_light(OnOff::Off);
+        while (true)
+        {
+            wait_until_button_pressed(io);
+            flash_until_button_released(io, timer);
+        }
+    }
+}
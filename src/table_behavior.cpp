@@ -0,0 +1,73 @@
+#include "table_behavior.h"
+
+namespace state_machine
+{
+    using States = TableButtonBehavior::States;
+    using Guard = TableButtonBehavior::Guard;
+    using Action = TableButtonBehavior::Action;
+
+    // Rows are grouped by state, in priority order within a state
+    const std::array<TableButtonBehavior::Transition, 6> TableButtonBehavior::table = {{
+        {States::NotPressed, Guard::ButtonPressed, Action::LightOnResetTimer, States::BlinkOn},
+        {States::BlinkOn, Guard::ButtonReleased, Action::None, States::ReleasedButton},
+        {States::BlinkOn, Guard::TimerExpired, Action::LightOffResetTimer, States::BlinkOff},
+        {States::BlinkOff, Guard::ButtonReleased, Action::None, States::ReleasedButton},
+        {States::BlinkOff, Guard::TimerExpired, Action::LightOnResetTimer, States::BlinkOn},
+        {States::ReleasedButton, Guard::Always, Action::LightOff, States::NotPressed},
+    }};
+
+    // Index of the first row for each state, plus one past the end
+    static constexpr std::array<std::size_t, 5> first_row = {0, 1, 3, 5, 6};
+
+    bool TableButtonBehavior::handle_state()
+    {
+        auto state = static_cast<std::size_t>(current_state);
+        for (auto row = first_row[state]; row < first_row[state + 1]; ++row)
+        {
+            const auto &transition = table[row];
+            if (check(transition.guard))
+            {
+                perform(transition.action);
+                current_state = transition.to;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool TableButtonBehavior::check(Guard guard)
+    {
+        switch (guard)
+        {
+        case Guard::Always:
+            return true;
+        case Guard::ButtonPressed:
+            return io.button_pressed();
+        case Guard::ButtonReleased:
+            return io.button_released();
+        case Guard::TimerExpired:
+            return timer.expired();
+        }
+        return false;
+    }
+
+    void TableButtonBehavior::perform(Action action)
+    {
+        switch (action)
+        {
+        case Action::None:
+            break;
+        case Action::LightOnResetTimer:
+            io.set_light(OnOff::On);
+            timer.reset(1.0);
+            break;
+        case Action::LightOffResetTimer:
+            io.set_light(OnOff::Off);
+            timer.reset(1.0);
+            break;
+        case Action::LightOff:
+            io.set_light(OnOff::Off);
+            break;
+        }
+    }
+}
@@ -0,0 +1,471 @@
+#include "trace_daemon.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "lib.h"
+
+namespace cells
+{
+    namespace
+    {
+        template <typename T>
+        void put(std::vector<std::uint8_t> &out, T value)
+        {
+            std::uint8_t bytes[sizeof(T)];
+            std::memcpy(bytes, &value, sizeof(T));
+            out.insert(out.end(), bytes, bytes + sizeof(T));
+        }
+
+        template <typename T>
+        T get(const std::uint8_t *in)
+        {
+            T value;
+            std::memcpy(&value, in, sizeof(T));
+            return value;
+        }
+
+        std::runtime_error system_error(const std::string &what)
+        {
+            return std::runtime_error(what + ": " + std::strerror(errno));
+        }
+
+        sockaddr_un socket_address(const std::string &path)
+        {
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            if (path.size() >= sizeof(address.sun_path))
+            {
+                throw std::runtime_error("socket path too long: " + path);
+            }
+            std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+            return address;
+        }
+
+        Grid parse_grid(std::span<const std::uint8_t> payload, std::size_t max_cells)
+        {
+            // Counted before parsing, so an oversized grid costs one pass over its text
+            auto cells = payload.size() - static_cast<std::size_t>(std::count(payload.begin(), payload.end(), '\n'));
+            if (cells > max_cells)
+            {
+                throw std::runtime_error("grid larger than " + std::to_string(max_cells) + " cells");
+            }
+            std::string text(payload.begin(), payload.end());
+            while (!text.empty() && text.back() == '\n')
+            {
+                text.pop_back();
+            }
+            if (text.empty())
+            {
+                throw std::runtime_error("empty grid");
+            }
+            return lib::lines_to_grid(text);
+        }
+    }
+
+    namespace trace_protocol
+    {
+        void put_header(std::vector<std::uint8_t> &out, std::uint32_t payload_length, std::uint8_t code, std::uint32_t tag)
+        {
+            put(out, payload_length);
+            put(out, code);
+            put(out, tag);
+        }
+
+        void put_trace(std::vector<std::uint8_t> &out, std::uint32_t tag, std::uint32_t grid, std::span<const Entry> entries)
+        {
+            put_header(out, static_cast<std::uint32_t>(4 + entries.size() * entry_size), static_cast<std::uint8_t>(Op::Trace), tag);
+            put(out, grid);
+            for (const auto &entry : entries)
+            {
+                put(out, std::get<0>(entry.location));
+                put(out, std::get<1>(entry.location));
+                put(out, static_cast<std::uint8_t>(entry.direction));
+            }
+        }
+    }
+
+    using namespace trace_protocol;
+
+    const TraceService::Resident &TraceService::resident(std::uint32_t handle) const
+    {
+        auto found = grids_.find(handle);
+        if (found == grids_.end())
+        {
+            throw std::runtime_error("unknown grid handle " + std::to_string(handle));
+        }
+        return *found->second;
+    }
+
+    void TraceService::respond(std::uint8_t op, std::uint32_t tag, std::span<const std::uint8_t> payload, std::vector<std::uint8_t> &output)
+    {
+        std::vector<std::uint8_t> reply;
+        try
+        {
+            switch (static_cast<Op>(op))
+            {
+            case Op::Load:
+            {
+                auto grid = parse_grid(payload, max_cells_);
+                const auto grid_bytes = static_cast<std::size_t>(grid.width() * grid.height()) * sizeof(Cell);
+                const auto available = memory_budget_ - std::min(memory_used_, memory_budget_);
+                if (grid_bytes > available)
+                {
+                    throw std::runtime_error("grid over the service memory budget");
+                }
+                // Throws before allocating if the graph would not fit either
+                auto loaded = std::make_unique<Resident>(std::move(grid), available - grid_bytes);
+                loaded->bytes = grid_bytes + loaded->graph.memory_bytes();
+                memory_used_ += loaded->bytes;
+                auto handle = next_handle_++;
+                grids_.emplace(handle, std::move(loaded));
+                put(reply, handle);
+                break;
+            }
+            case Op::Trace:
+            {
+                if (payload.size() < 4 || (payload.size() - 4) % entry_size != 0)
+                {
+                    throw std::runtime_error("malformed trace request");
+                }
+                const auto &graph = resident(get<std::uint32_t>(payload.data())).graph;
+                reply.reserve((payload.size() - 4) / entry_size * 8);
+                for (auto at = payload.data() + 4; at < payload.data() + payload.size(); at += entry_size)
+                {
+                    auto direction = at[16];
+                    if (direction > static_cast<std::uint8_t>(Direction::Right))
+                    {
+                        throw std::runtime_error("bad direction");
+                    }
+                    XY location{get<std::int64_t>(at), get<std::int64_t>(at + 8)};
+                    put(reply, static_cast<std::uint64_t>(graph.trace(location, static_cast<Direction>(direction))));
+                }
+                break;
+            }
+            case Op::Unload:
+            {
+                auto found = payload.size() == 4 ? grids_.find(get<std::uint32_t>(payload.data())) : grids_.end();
+                if (found == grids_.end())
+                {
+                    throw std::runtime_error("unknown grid handle");
+                }
+                memory_used_ -= found->second->bytes;
+                grids_.erase(found);
+                break;
+            }
+            default:
+                throw std::runtime_error("unknown op " + std::to_string(op));
+            }
+        }
+        catch (const std::exception &error)
+        {
+            std::string message = error.what();
+            put_header(output, static_cast<std::uint32_t>(message.size()), static_cast<std::uint8_t>(Status::Error), tag);
+            output.insert(output.end(), message.begin(), message.end());
+            return;
+        }
+        put_header(output, static_cast<std::uint32_t>(reply.size()), static_cast<std::uint8_t>(Status::Ok), tag);
+        output.insert(output.end(), reply.begin(), reply.end());
+    }
+
+    std::size_t TraceService::handle(std::span<const std::uint8_t> input, std::vector<std::uint8_t> &output)
+    {
+        std::size_t consumed = 0;
+        while (input.size() - consumed >= header_size)
+        {
+            const auto *header = input.data() + consumed;
+            auto length = get<std::uint32_t>(header);
+            if (length > max_payload)
+            {
+                throw std::runtime_error("trace request too large");
+            }
+            if (input.size() - consumed - header_size < length)
+            {
+                break;
+            }
+            respond(header[4], get<std::uint32_t>(header + 5), input.subspan(consumed + header_size, length), output);
+            consumed += header_size + length;
+        }
+        return consumed;
+    }
+
+    TraceServer::TraceServer(const std::string &socket_path) : path_(socket_path)
+    {
+        auto address = socket_address(path_);
+        listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listen_fd_ < 0)
+        {
+            throw system_error("socket");
+        }
+        ::unlink(path_.c_str());
+        if (::bind(listen_fd_, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0 ||
+            ::listen(listen_fd_, 64) != 0 ||
+            ::pipe2(wake_, O_NONBLOCK | O_CLOEXEC) != 0)
+        {
+            auto error = system_error("listen on " + path_);
+            ::close(listen_fd_);
+            throw error;
+        }
+    }
+
+    TraceServer::~TraceServer()
+    {
+        for (auto &client : clients_)
+        {
+            ::close(client.fd);
+        }
+        ::close(listen_fd_);
+        ::close(wake_[0]);
+        ::close(wake_[1]);
+        ::unlink(path_.c_str());
+    }
+
+    void TraceServer::stop()
+    {
+        stopping_ = true;
+        char byte = 0;
+        [[maybe_unused]] auto written = ::write(wake_[1], &byte, 1);
+    }
+
+    bool TraceServer::serve(Client &client, short events)
+    {
+        if (events & (POLLIN | POLLHUP | POLLERR))
+        {
+            std::uint8_t buffer[64 * 1024];
+            for (;;)
+            {
+                auto got = ::read(client.fd, buffer, sizeof(buffer));
+                if (got > 0)
+                {
+                    client.in.insert(client.in.end(), buffer, buffer + got);
+                    continue;
+                }
+                if (got == 0 || (errno != EAGAIN && errno != EINTR))
+                {
+                    return false;
+                }
+                if (errno == EAGAIN)
+                {
+                    break;
+                }
+            }
+            try
+            {
+                auto consumed = service_.handle(client.in, client.out);
+                client.in.erase(client.in.begin(), client.in.begin() + static_cast<std::ptrdiff_t>(consumed));
+            }
+            catch (const std::exception &)
+            {
+                // A corrupt stream cannot be resynchronized
+                return false;
+            }
+        }
+        while (client.written < client.out.size())
+        {
+            auto sent = ::send(client.fd, client.out.data() + client.written, client.out.size() - client.written, MSG_NOSIGNAL);
+            if (sent < 0)
+            {
+                if (errno == EAGAIN)
+                {
+                    return true;
+                }
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return false;
+            }
+            client.written += static_cast<std::size_t>(sent);
+        }
+        client.out.clear();
+        client.written = 0;
+        return true;
+    }
+
+    void TraceServer::run()
+    {
+        // Stop reading a client with this much unsent output
+        constexpr std::size_t backlog = 1024 * 1024;
+        std::vector<pollfd> polled;
+        while (!stopping_)
+        {
+            polled.clear();
+            polled.push_back({wake_[0], POLLIN, 0});
+            polled.push_back({listen_fd_, POLLIN, 0});
+            for (const auto &client : clients_)
+            {
+                short events = client.out.size() - client.written < backlog ? POLLIN : 0;
+                if (client.written < client.out.size())
+                {
+                    events |= POLLOUT;
+                }
+                polled.push_back({client.fd, events, 0});
+            }
+            if (::poll(polled.data(), polled.size(), -1) < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                throw system_error("poll");
+            }
+            // Clients accepted below are polled from the next pass
+            std::size_t polled_clients = clients_.size();
+            if (polled[1].revents & POLLIN)
+            {
+                for (int fd; (fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0;)
+                {
+                    clients_.push_back({fd, {}, {}, 0});
+                }
+            }
+            std::size_t kept = 0;
+            for (std::size_t i = 0; i < clients_.size(); ++i)
+            {
+                auto events = i < polled_clients ? polled[i + 2].revents : 0;
+                if (events == 0 || serve(clients_[i], events))
+                {
+                    if (kept != i)
+                    {
+                        clients_[kept] = std::move(clients_[i]);
+                    }
+                    kept++;
+                }
+                else
+                {
+                    ::close(clients_[i].fd);
+                }
+            }
+            clients_.resize(kept, Client{-1, {}, {}, 0});
+        }
+        char drain[64];
+        while (::read(wake_[0], drain, sizeof(drain)) > 0)
+        {
+        }
+        stopping_ = false;
+    }
+
+    TraceClient::TraceClient(const std::string &socket_path)
+    {
+        auto address = socket_address(socket_path);
+        fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd_ < 0)
+        {
+            throw system_error("socket");
+        }
+        if (::connect(fd_, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0)
+        {
+            auto error = system_error("connect to " + socket_path);
+            ::close(fd_);
+            throw error;
+        }
+    }
+
+    TraceClient::~TraceClient()
+    {
+        ::close(fd_);
+    }
+
+    void TraceClient::send(const std::vector<std::uint8_t> &bytes)
+    {
+        for (std::size_t sent = 0; sent < bytes.size();)
+        {
+            auto count = ::send(fd_, bytes.data() + sent, bytes.size() - sent, MSG_NOSIGNAL);
+            if (count < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                throw system_error("send to trace daemon");
+            }
+            sent += static_cast<std::size_t>(count);
+        }
+    }
+
+    std::vector<std::uint8_t> TraceClient::receive(std::uint32_t tag)
+    {
+        auto read_exactly = [this](std::uint8_t *into, std::size_t size)
+        {
+            for (std::size_t got = 0; got < size;)
+            {
+                auto count = ::read(fd_, into + got, size - got);
+                if (count == 0)
+                {
+                    throw std::runtime_error("trace daemon closed the connection");
+                }
+                if (count < 0)
+                {
+                    if (errno == EINTR)
+                    {
+                        continue;
+                    }
+                    throw system_error("read from trace daemon");
+                }
+                got += static_cast<std::size_t>(count);
+            }
+        };
+        std::uint8_t header[header_size];
+        read_exactly(header, header_size);
+        std::vector<std::uint8_t> payload(get<std::uint32_t>(header));
+        read_exactly(payload.data(), payload.size());
+        if (get<std::uint32_t>(header + 5) != tag)
+        {
+            throw std::runtime_error("trace daemon response out of order");
+        }
+        if (header[4] != static_cast<std::uint8_t>(Status::Ok))
+        {
+            throw std::runtime_error("trace daemon: " + std::string(payload.begin(), payload.end()));
+        }
+        return payload;
+    }
+
+    std::vector<std::uint8_t> TraceClient::call(Op op, std::span<const std::uint8_t> payload)
+    {
+        auto tag = next_tag_++;
+        std::vector<std::uint8_t> request;
+        put_header(request, static_cast<std::uint32_t>(payload.size()), static_cast<std::uint8_t>(op), tag);
+        request.insert(request.end(), payload.begin(), payload.end());
+        send(request);
+        return receive(tag);
+    }
+
+    std::uint32_t TraceClient::load(const std::string &grid_text)
+    {
+        auto reply = call(Op::Load, std::span(reinterpret_cast<const std::uint8_t *>(grid_text.data()), grid_text.size()));
+        return get<std::uint32_t>(reply.data());
+    }
+
+    std::vector<std::uint64_t> TraceClient::trace(std::uint32_t grid, std::span<const Entry> entries)
+    {
+        return receive_trace(send_trace(grid, entries));
+    }
+
+    void TraceClient::unload(std::uint32_t grid)
+    {
+        std::vector<std::uint8_t> payload;
+        put(payload, grid);
+        call(Op::Unload, payload);
+    }
+
+    std::uint32_t TraceClient::send_trace(std::uint32_t grid, std::span<const Entry> entries)
+    {
+        auto tag = next_tag_++;
+        std::vector<std::uint8_t> request;
+        put_trace(request, tag, grid, entries);
+        send(request);
+        return tag;
+    }
+
+    std::vector<std::uint64_t> TraceClient::receive_trace(std::uint32_t tag)
+    {
+        auto reply = receive(tag);
+        std::vector<std::uint64_t> counts(reply.size() / 8);
+        std::memcpy(counts.data(), reply.data(), counts.size() * 8);
+        return counts;
+    }
+}
@@ -0,0 +1,44 @@
+#include "trace_timeline.h"
+
+namespace cells
+{
+    TraceTimeline trace_timeline(const Grid &grid, const XY &entry_location, const Direction &entry_direction)
+    {
+        TraceTimeline timeline;
+        const auto width = grid.width();
+        const auto height = grid.height();
+        auto [entry_x, entry_y] = entry_location;
+        if (entry_x < 0 || entry_y < 0 || entry_x >= width || entry_y >= height)
+        {
+            return timeline;
+        }
+        std::vector<std::uint8_t> visited(static_cast<std::size_t>(width * height), 0);
+        std::vector<BeamAt<Coord>> front = {{entry_x, entry_y, entry_direction}};
+        std::vector<BeamAt<Coord>> next_front;
+
+        while (!front.empty())
+        {
+            std::uint32_t lit = 0;
+            walk_beams(front, next_front, width, height, [&](Coord x, Coord y, Direction direction) -> std::optional<Cell>
+                       {
+                auto &seen = visited[static_cast<std::size_t>(y * width + x)];
+                auto bit = static_cast<std::uint8_t>(1 << static_cast<int>(direction));
+                if (seen & bit)
+                {
+                    return std::nullopt;
+                }
+                lit += seen == 0;
+                seen |= bit;
+                return grid.cell(x, y); });
+            timeline.new_cells.push_back(lit);
+            timeline.energized += lit;
+            front.swap(next_front);
+        }
+        // The last steps may only retrace lit cells or leave the grid
+        while (!timeline.new_cells.empty() && timeline.new_cells.back() == 0)
+        {
+            timeline.new_cells.pop_back();
+        }
+        return timeline;
+    }
+}
@@ -0,0 +1,119 @@
+#include "transition_metrics.h"
+#include <bit>
+#include <chrono>
+
+namespace state_machine
+{
+    static std::size_t index(ButtonStates state)
+    {
+        return static_cast<std::size_t>(state);
+    }
+
+    static std::size_t thread_number()
+    {
+        static std::atomic<std::size_t> next_thread{0};
+        thread_local std::size_t number = next_thread.fetch_add(1, std::memory_order_relaxed);
+        return number;
+    }
+
+    TransitionMetrics::Shard &TransitionMetrics::local_shard()
+    {
+        return shards_[thread_number() % shard_count];
+    }
+
+    std::size_t TransitionMetrics::bucket_for(double dwell_seconds)
+    {
+        if (!(dwell_seconds >= 1e-6))
+        {
+            return 0;
+        }
+        // Anything from the last bucket's lower bound up, infinity included, goes
+        // there before the cast, which would be undefined for values past uint64_t
+        constexpr auto last_bucket_start = static_cast<double>(std::uint64_t(1) << (histogram_buckets - 2));
+        if (dwell_seconds * 1e6 >= last_bucket_start)
+        {
+            return histogram_buckets - 1;
+        }
+        auto microseconds = static_cast<std::uint64_t>(dwell_seconds * 1e6);
+        auto bucket = static_cast<std::size_t>(std::bit_width(microseconds));
+        return bucket < histogram_buckets ? bucket : histogram_buckets - 1;
+    }
+
+    void TransitionMetrics::record(ButtonStates from, ButtonStates to, double dwell_seconds)
+    {
+        auto &shard = local_shard();
+        auto relaxed = std::memory_order_relaxed;
+        shard.transitions[index(from) * button_state_count + index(to)].fetch_add(1, relaxed);
+        // 2^64 as a double; the cast is only defined below it
+        constexpr double nanoseconds_limit = 18446744073709551616.0;
+        std::uint64_t nanoseconds = 0;
+        if (dwell_seconds * 1e9 >= nanoseconds_limit)
+        {
+            nanoseconds = UINT64_MAX;
+        }
+        else if (dwell_seconds > 0.0)
+        {
+            nanoseconds = static_cast<std::uint64_t>(dwell_seconds * 1e9);
+        }
+        // Saturating add, a running total never wraps back to small values
+        auto &total = shard.dwell_nanoseconds[index(from)];
+        auto before = total.load(relaxed);
+        while (!total.compare_exchange_weak(before, nanoseconds > UINT64_MAX - before ? UINT64_MAX : before + nanoseconds, relaxed))
+        {
+        }
+        shard.histograms[index(from)][bucket_for(dwell_seconds)].fetch_add(1, relaxed);
+    }
+
+    std::uint64_t TransitionMetrics::transition_count(ButtonStates from, ButtonStates to) const
+    {
+        std::uint64_t total = 0;
+        for (const auto &shard : shards_)
+        {
+            total += shard.transitions[index(from) * button_state_count + index(to)].load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    std::uint64_t TransitionMetrics::dwell_count(ButtonStates state) const
+    {
+        std::uint64_t total = 0;
+        for (const auto &shard : shards_)
+        {
+            for (const auto &bucket : shard.histograms[index(state)])
+            {
+                total += bucket.load(std::memory_order_relaxed);
+            }
+        }
+        return total;
+    }
+
+    double TransitionMetrics::total_dwell_seconds(ButtonStates state) const
+    {
+        // Summed as doubles, saturated shards would overflow an integer sum
+        double total = 0.0;
+        for (const auto &shard : shards_)
+        {
+            total += static_cast<double>(shard.dwell_nanoseconds[index(state)].load(std::memory_order_relaxed));
+        }
+        return total * 1e-9;
+    }
+
+    TransitionMetrics::Histogram TransitionMetrics::dwell_histogram(ButtonStates state) const
+    {
+        Histogram histogram{};
+        for (const auto &shard : shards_)
+        {
+            for (std::size_t bucket = 0; bucket < histogram_buckets; ++bucket)
+            {
+                histogram[bucket] += shard.histograms[index(state)][bucket].load(std::memory_order_relaxed);
+            }
+        }
+        return histogram;
+    }
+
+    double MetricsObserver::steady_seconds()
+    {
+        auto since_epoch = std::chrono::steady_clock::now().time_since_epoch();
+        return std::chrono::duration<double>(since_epoch).count();
+    }
+}
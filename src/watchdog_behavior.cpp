@@ -0,0 +1,71 @@
+#include "watchdog_behavior.h"
+
+namespace state_machine
+{
+    FrameTask monitor_voltage_transition(ILightFeedback &feedback, ITimer &transition_timer,
+                                         bool expected_reading, double timeout_seconds, const char *&failure)
+    {
+        // Wait until the reading goes to the expected value or the timer expires
+        bool transitioned = co_await with_timeout(until([&feedback, expected_reading]
+                                                        { return feedback.light_voltage() == expected_reading; }),
+                                                  transition_timer, timeout_seconds);
+        if (!transitioned)
+        {
+            failure = "Timer expired before voltage transition";
+            co_return;
+        }
+
+        // It transitioned to the expected reading, now wait until it transitions back
+        co_await until([&feedback, expected_reading]
+                       { return feedback.light_voltage() != expected_reading; });
+        failure = "Voltage transitioned away from expected reading after transition.";
+    }
+
+    FrameTask WatchdogButtonBehavior::run()
+    {
+        io.set_light(OnOff::Off);
+        while (error_ == nullptr)
+        {
+            current_state = States::NotPressed;
+            co_await button_pressed(io);
+            co_await flash_until_button_released();
+        }
+    }
+
+    FrameTask WatchdogButtonBehavior::flash_until_button_released()
+    {
+        // Setup our initial state of the light being on and the timer being reset
+        OnOff light_state = OnOff::On;
+        current_state = States::BlinkOn;
+        io.set_light(light_state);
+        timer.reset(1.0);
+
+        while (true)
+        {
+            const char *failure = nullptr;
+            auto first = co_await when_any(
+                button_released(io), // Good, if the button is released, we're done
+                timer_expired(timer), // Good, if the timer expires, we need to flip the light
+                monitor_voltage_transition(feedback, transition_timer, light_state == OnOff::On,
+                                           transition_seconds, failure)); // Bad, the light did not follow
+            if (first == 0)
+            {
+                break;
+            }
+            if (first == 2)
+            {
+                error_ = failure;
+                co_return;
+            }
+            // Inside the loop the timer expired, reset timer, flip light state, and set light
+            timer.reset(1.0);
+            light_state = toggle(light_state);
+            io.set_light(light_state);
+            current_state = (light_state == OnOff::On) ? States::BlinkOn : States::BlinkOff;
+        }
+
+        // When the button is released, set the light back to off.
+        current_state = States::ReleasedButton;
+        io.set_light(OnOff::Off);
+    }
+}
@@ -14,3 +14,18 @@ TEST(AoC, Part1) {
 
     ASSERT_EQ(count, 46);
 }
+
+TEST(AoC, MultiSourceTrace) {
+    auto cells = lib::lines_to_grid(std::string(lib::sample_data()));
+
+    // One source is the plain trace
+    std::vector<cells::Beam> sources = {cells::Beam({0, 0}, cells::Direction::Right)};
+    ASSERT_EQ(cells::trace_grid(cells, sources), 46);
+
+    // (1, 0) lies on the first trace and adds nothing; (3, 0) Down alone lights 51
+    sources.emplace_back(cells::XY{1, 0}, cells::Direction::Right);
+    sources.emplace_back(cells::XY{3, 0}, cells::Direction::Down);
+    ASSERT_EQ(cells::trace_grid(cells, sources), 52);
+
+    ASSERT_EQ(cells::trace_grid(cells, std::span<const cells::Beam>{}), 0);
+}
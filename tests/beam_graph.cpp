@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+#include "beam_graph.h"
+#include "lib.h"
+#include "multi_trace.h"
+
+static void expect_same_traces(const cells::Grid &grid)
+{
+    cells::BeamGraph graph(grid);
+    for (const auto &entry : cells::edge_entries(grid.width(), grid.height()))
+    {
+        ASSERT_EQ(cells::trace_grid(graph, entry.location, entry.direction), cells::trace_grid(grid, entry.location, entry.direction));
+    }
+    // Entries starting inside the grid, including on obstacles
+    for (cells::Coord y = 0; y < grid.height(); y += 3)
+    {
+        for (cells::Coord x = 0; x < grid.width(); x += 5)
+        {
+            for (auto direction : {cells::Direction::Up, cells::Direction::Down, cells::Direction::Left, cells::Direction::Right})
+            {
+                ASSERT_EQ(graph.trace({x, y}, direction), cells::trace_grid(grid, {x, y}, direction));
+            }
+        }
+    }
+}
+
+TEST(BeamGraph, SampleCondensesCycles)
+{
+    auto grid = lib::lines_to_grid(std::string(lib::sample_data()));
+    cells::BeamGraph graph(grid);
+    ASSERT_EQ(graph.trace({0, 0}, cells::Direction::Right), 46);
+    ASSERT_EQ(graph.trace({3, 0}, cells::Direction::Down), 51);
+    ASSERT_EQ(graph.trace({-1, 0}, cells::Direction::Right), 0);
+    // The splitters in the sample feed each other, so some segments share a component
+    ASSERT_LT(graph.component_count(), graph.node_count());
+    expect_same_traces(grid);
+}
+
+TEST(BeamGraph, RandomGridsMatchStackEngine)
+{
+    for (unsigned seed = 1; seed < 5; ++seed)
+    {
+        expect_same_traces(lib::random_grid(31, 23, 0.1 * seed, seed));
+    }
+    expect_same_traces(lib::random_grid(12, 9, 0.0, 1));
+}
+
+TEST(BeamGraph, StaysWithinMemoryBudget)
+{
+    // A set per component would take width * height bits each, gigabytes at this size
+    auto grid = lib::random_grid(600, 600, 0.05, 3);
+    cells::BeamGraph graph(grid);
+    ASSERT_LT(graph.memory_bytes(), std::size_t(256) << 20);
+    ASSERT_EQ(graph.trace({0, 17}, cells::Direction::Right), cells::trace_grid(grid, {0, 17}, cells::Direction::Right));
+    ASSERT_EQ(graph.trace({300, 300}, cells::Direction::Up), cells::trace_grid(grid, {300, 300}, cells::Direction::Up));
+
+    ASSERT_THROW(cells::BeamGraph(grid, std::size_t(1) << 20), std::runtime_error);
+}
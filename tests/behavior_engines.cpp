@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+#include "batch_behavior.h"
+#include "coroutine_behavior.h"
+#include "simulation.h"
+#include "table_behavior.h"
+
+using namespace state_machine;
+
+template <typename Behavior>
+static std::vector<LightSample> press_pattern_trace()
+{
+    Simulation<Behavior> sim;
+    auto index = sim.add_instance();
+    sim.schedule_button(index, 0.5, true);
+    sim.schedule_button(index, 3.25, false);
+    sim.schedule_button(index, 4.0, true);
+    sim.schedule_button(index, 5.0, false);
+    sim.run_until(10.0);
+    return sim[index].io.trace;
+}
+
+TEST(BehaviorEngines, TableMatchesSwitch)
+{
+    ASSERT_EQ(press_pattern_trace<TableButtonBehavior>(), press_pattern_trace<PolledButtonBehavior>());
+}
+
+TEST(BehaviorEngines, CoroutineMatchesSwitch)
+{
+    ASSERT_EQ(press_pattern_trace<CoroutineButtonBehavior>(), press_pattern_trace<PolledButtonBehavior>());
+    ASSERT_GT(CoroutineButtonBehavior::frame_size(), 0);
+}
+
+TEST(BehaviorEngines, BatchMatchesSwitch)
+{
+    VirtualClock clock;
+    SimIO io(clock);
+    SimTimer timer(clock);
+    PolledButtonBehavior behavior(io, timer);
+
+    ButtonBehaviorBatch batch;
+    auto index = batch.add();
+
+    // Step both with a quarter second frame, pressing and releasing along the way
+    for (int frame = 0; frame < 40; ++frame)
+    {
+        clock.advance_to(frame * 0.25);
+        bool pressed = (frame >= 2 && frame < 20) || frame >= 30;
+        io.button_pressed_value = pressed;
+        batch.set_button(index, pressed);
+
+        behavior.do_work();
+        batch.step(clock.now());
+
+        ASSERT_EQ(batch.light(index), io.light_value);
+        ASSERT_EQ(batch.state(index), behavior.get_state());
+    }
+}
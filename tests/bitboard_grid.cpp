@@ -0,0 +1,39 @@
+#include <gtest/gtest.h>
+#include "bitboard_grid.h"
+#include "lib.h"
+#include "multi_trace.h"
+
+static void expect_same_traces(const cells::Grid &grid)
+{
+    cells::BitboardGrid bitboard(grid);
+    for (const auto &entry : cells::edge_entries(grid.width(), grid.height()))
+    {
+        ASSERT_EQ(cells::trace_grid(bitboard, entry.location, entry.direction), cells::trace_grid(grid, entry.location, entry.direction));
+    }
+}
+
+TEST(BitboardGrid, SampleMatchesStackEngine)
+{
+    auto grid = lib::lines_to_grid(std::string(lib::sample_data()));
+    cells::BitboardGrid bitboard(grid);
+    ASSERT_EQ(cells::trace_grid(bitboard, {0, 0}, cells::Direction::Right), 46);
+    ASSERT_EQ(cells::trace_grid(bitboard, {3, 0}, cells::Direction::Down), 51);
+    ASSERT_EQ(cells::trace_grid(bitboard, {-1, 0}, cells::Direction::Right), 0);
+    expect_same_traces(grid);
+}
+
+TEST(BitboardGrid, RowsSpanningSeveralWords)
+{
+    // 130 wide uses three words per row with a partial last word
+    for (unsigned seed = 1; seed < 4; ++seed)
+    {
+        expect_same_traces(lib::random_grid(130, 7, 0.05 * seed, seed));
+    }
+    // Exactly one full word per row
+    expect_same_traces(lib::random_grid(64, 9, 0.2, 9));
+}
+
+TEST(BitboardGrid, DenseSplitterGrid)
+{
+    expect_same_traces(lib::random_grid(40, 30, 0.6, 5));
+}
@@ -24,4 +24,57 @@ TEST(CellReading, OutOfRangeFails) {
     ASSERT_EQ(cells.at(0, 0), cells::Cell::Space);
     ASSERT_TRUE(cells.at(1, 0));
     ASSERT_FALSE(cells.at(-1, 0));
-}
\ No newline at end of file
+}
+TEST(CellReading, ChunkedParseMatchesAcrossThreadCounts) {
+    // Big enough for several megabyte chunks, with rows straddling every split point
+    const int width = 1031;
+    const int height = 4099;
+    auto grid = lib::random_grid(width, height, 0.2, 6);
+    auto text = lib::grid_to_lines(grid);
+
+    for (unsigned threads : {1u, 3u, 0u})
+    {
+        auto parsed = lib::lines_to_grid(text, threads);
+        ASSERT_EQ(parsed.width(), width);
+        ASSERT_EQ(parsed.height(), height);
+        for (cells::Coord y = 0; y < height; y += 97)
+        {
+            for (cells::Coord x = 0; x < width; ++x)
+            {
+                ASSERT_EQ(parsed.at(x, y), grid.at(x, y));
+            }
+        }
+        ASSERT_EQ(parsed.at(width - 1, height - 1), grid.at(width - 1, height - 1));
+    }
+
+    // A bad character or a short row is reported from whichever chunk has it
+    auto bad = text;
+    bad[bad.size() / 2] = 'x';
+    ASSERT_THROW(lib::lines_to_grid(bad, 4), std::runtime_error);
+    auto ragged = text;
+    ragged.erase(ragged.size() - 3, 1);
+    ASSERT_THROW(lib::lines_to_grid(ragged, 4), std::runtime_error);
+}
+
+TEST(CellReading, TrailingNewlineAndEmptyInput) {
+    auto grid = lib::lines_to_grid("..|\n/..\n");
+    ASSERT_EQ(grid.width(), 3);
+    ASSERT_EQ(grid.height(), 2);
+    ASSERT_EQ(lib::lines_to_grid("").height(), 0);
+    ASSERT_THROW(lib::lines_to_grid("..\n.\n"), std::runtime_error);
+}
+
+TEST(CellReading, GridToLinesRoundTrips) {
+    auto text = std::string(lib::sample_data()) + "\n";
+    ASSERT_EQ(lib::grid_to_lines(lib::lines_to_grid(text)), text);
+    auto grid = lib::random_grid(13, 7, 0.5, 2);
+    auto parsed = lib::lines_to_grid(lib::grid_to_lines(grid));
+    for (cells::Coord y = 0; y < grid.height(); ++y)
+    {
+        for (cells::Coord x = 0; x < grid.width(); ++x)
+        {
+            ASSERT_EQ(parsed.at(x, y), grid.at(x, y));
+        }
+    }
+    ASSERT_EQ(lib::grid_to_lines(lib::lines_to_grid("")), "");
+}
@@ -0,0 +1,196 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+#include "simulation.h"
+#include "watchdog_behavior.h"
+
+using namespace state_machine;
+
+TEST(Combinators, WhenAnyReportsFirstFinished)
+{
+    bool a = false;
+    bool b = false;
+    std::size_t winner = 99;
+    // Lambda coroutines keep referring to their closure, so it must outlive the task
+    auto body = [&]() -> FrameTask
+    {
+        winner = co_await when_any(until([&]
+                                         { return a; }),
+                                   until([&]
+                                         { return b; }));
+    };
+    auto task = body();
+
+    task.resume();
+    task.resume();
+    ASSERT_FALSE(task.done());
+    b = true;
+    task.resume();
+    ASSERT_TRUE(task.done());
+    ASSERT_EQ(winner, 1);
+}
+
+TEST(Combinators, WhenAllWaitsForEveryOperation)
+{
+    int a = 0;
+    int b = 0;
+    auto body = [&]() -> FrameTask
+    {
+        co_await when_all(until([&]
+                                { return ++a >= 2; }),
+                          until([&]
+                                { return ++b >= 4; }));
+    };
+    auto task = body();
+
+    for (int frame = 0; frame < 3; ++frame)
+    {
+        task.resume();
+        ASSERT_FALSE(task.done());
+    }
+    task.resume();
+    ASSERT_TRUE(task.done());
+    // The first finished early and was not polled again
+    ASSERT_EQ(a, 2);
+    ASSERT_EQ(b, 4);
+}
+
+TEST(Combinators, WithTimeoutReportsExpiry)
+{
+    VirtualClock clock;
+    SimTimer timer(clock);
+    bool never = false;
+    bool finished_first = true;
+    auto body = [&]() -> FrameTask
+    {
+        finished_first = co_await with_timeout(until([&]
+                                                     { return never; }),
+                                               timer, 0.5);
+    };
+    auto task = body();
+
+    task.resume();
+    clock.advance_to(0.4);
+    task.resume();
+    ASSERT_FALSE(task.done());
+    clock.advance_to(0.5);
+    task.resume();
+    ASSERT_TRUE(task.done());
+    ASSERT_FALSE(finished_first);
+}
+
+TEST(Combinators, CoroutineFramesAreRecycled)
+{
+    auto block = FrameRecycler::allocate(100);
+    FrameRecycler::release(block, 100);
+    // Any size in the same size class gets the released block back
+    auto again = FrameRecycler::allocate(120);
+    ASSERT_EQ(again, block);
+    FrameRecycler::release(again, 120);
+}
+
+TEST(Combinators, FrameCacheIsCappedAndPerThread)
+{
+    std::size_t other_thread = 0;
+    std::thread([&]
+                {
+        std::vector<void *> frames;
+        for (std::size_t i = 0; i < FrameRecycler::max_cached + 10; ++i)
+        {
+            frames.push_back(FrameRecycler::allocate(200));
+        }
+        for (auto frame : frames)
+        {
+            FrameRecycler::release(frame, 200);
+        }
+        // The rest went back to the allocator, what is cached is freed as the thread exits
+        other_thread = FrameRecycler::cached(); })
+        .join();
+    ASSERT_EQ(other_thread, FrameRecycler::max_cached);
+}
+
+class FeedbackIO : public IIO, public ILightFeedback
+{
+public:
+    void set_light(OnOff on_or_off) override
+    {
+        light_value = on_or_off;
+    }
+    bool button_pressed() override
+    {
+        return button_pressed_value;
+    }
+    bool button_released() override
+    {
+        return !button_pressed_value;
+    }
+    bool light_voltage() override
+    {
+        return !broken && light_value == OnOff::On;
+    }
+    OnOff light_value = OnOff::Off;
+    bool button_pressed_value = false;
+    bool broken = false;
+};
+
+struct WatchdogRig
+{
+    WatchdogRig() : timer(clock), transition_timer(clock), behavior(io, io, timer, transition_timer) {}
+
+    void run_until(double end)
+    {
+        while (clock.now() < end)
+        {
+            clock.advance_to(clock.now() + 0.05);
+            behavior.do_work();
+        }
+    }
+
+    VirtualClock clock;
+    FeedbackIO io;
+    SimTimer timer;
+    SimTimer transition_timer;
+    WatchdogButtonBehavior behavior;
+};
+
+TEST(Watchdog, HealthyLightBlinksUntilReleased)
+{
+    WatchdogRig rig;
+    rig.behavior.do_work();
+    rig.io.button_pressed_value = true;
+    rig.run_until(0.5);
+    ASSERT_EQ(rig.io.light_value, OnOff::On);
+    rig.run_until(1.5);
+    ASSERT_EQ(rig.io.light_value, OnOff::Off);
+    ASSERT_EQ(rig.behavior.get_state(), ButtonStates::BlinkOff);
+    rig.run_until(10.0);
+    ASSERT_EQ(rig.behavior.error(), nullptr);
+
+    rig.io.button_pressed_value = false;
+    rig.run_until(10.2);
+    ASSERT_EQ(rig.io.light_value, OnOff::Off);
+    ASSERT_EQ(rig.behavior.get_state(), ButtonStates::NotPressed);
+    ASSERT_EQ(rig.behavior.error(), nullptr);
+}
+
+TEST(Watchdog, LightThatNeverLightsIsReported)
+{
+    WatchdogRig rig;
+    rig.io.broken = true;
+    rig.behavior.do_work();
+    rig.io.button_pressed_value = true;
+    rig.run_until(0.5);
+    ASSERT_STREQ(rig.behavior.error(), "Timer expired before voltage transition");
+}
+
+TEST(Watchdog, LightThatDropsOutIsReported)
+{
+    WatchdogRig rig;
+    rig.behavior.do_work();
+    rig.io.button_pressed_value = true;
+    rig.run_until(0.5);
+    ASSERT_EQ(rig.behavior.error(), nullptr);
+    rig.io.broken = true;
+    rig.run_until(0.6);
+    ASSERT_STREQ(rig.behavior.error(), "Voltage transitioned away from expected reading after transition.");
+}
@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <functional>
+#include "edge_search.h"
+#include "lib.h"
+
+static void expect_matches_trace_grid(const cells::Grid &grid, const cells::EdgeSweep &sweep)
+{
+    ASSERT_EQ(sweep.entries, cells::edge_entries(grid.width(), grid.height()));
+    for (std::size_t i = 0; i < sweep.entries.size(); ++i)
+    {
+        const auto &entry = sweep.entries[i];
+        ASSERT_EQ(sweep.energized[i], cells::trace_grid(grid, entry.location, entry.direction));
+    }
+}
+
+TEST(EdgeSearch, SampleBestEntry)
+{
+    auto grid = lib::lines_to_grid(std::string(lib::sample_data()));
+    auto sweep = cells::sweep_edges(grid);
+    expect_matches_trace_grid(grid, sweep);
+    ASSERT_EQ(sweep.energized[sweep.best()], 51);
+    ASSERT_EQ(sweep.entries[sweep.best()], (cells::Entry{{3, 0}, cells::Direction::Down}));
+}
+
+TEST(EdgeSearch, SparseGridsShareTraces)
+{
+    for (unsigned seed = 1; seed < 6; ++seed)
+    {
+        auto grid = lib::random_grid(45, 35, 0.02 * seed, seed);
+        auto sweep = cells::sweep_edges(grid);
+        expect_matches_trace_grid(grid, sweep);
+        ASSERT_LT(sweep.full_traces, sweep.entries.size());
+    }
+}
+
+TEST(EdgeSearch, EmptyAndDenseGrids)
+{
+    auto empty = lib::random_grid(6, 4, 0.0, 1);
+    auto sweep = cells::sweep_edges(empty);
+    expect_matches_trace_grid(empty, sweep);
+    ASSERT_EQ(sweep.full_traces, 0);
+    expect_matches_trace_grid(lib::random_grid(20, 20, 0.7, 3), cells::sweep_edges(lib::random_grid(20, 20, 0.7, 3)));
+}
+
+TEST(EdgeSearch, TopEdgesMatchFullSweep)
+{
+    for (unsigned seed = 1; seed < 5; ++seed)
+    {
+        auto grid = lib::random_grid(40, 30, 0.04 * seed, seed);
+        auto sweep = cells::sweep_edges(grid);
+        auto counts = sweep.energized;
+        std::sort(counts.begin(), counts.end(), std::greater<>());
+
+        const std::size_t k = 5;
+        auto top = cells::top_edges(cells::BeamGraph(grid), k);
+        ASSERT_EQ(top.energized, std::vector<std::size_t>(counts.begin(), counts.begin() + k));
+        for (std::size_t i = 0; i < k; ++i)
+        {
+            ASSERT_EQ(top.energized[i], cells::trace_grid(grid, top.entries[i].location, top.entries[i].direction));
+        }
+        ASSERT_LE(top.exact_traces, sweep.entries.size());
+    }
+
+    auto sample = cells::BeamGraph(lib::lines_to_grid(std::string(lib::sample_data())));
+    auto best = cells::top_edges(sample, 1);
+    ASSERT_EQ(best.entries, std::vector<cells::Entry>{(cells::Entry{{3, 0}, cells::Direction::Down})});
+    ASSERT_TRUE(cells::top_edges(sample, 0).entries.empty());
+}
+
+TEST(EdgeSearch, TraceExceeds)
+{
+    auto grid = lib::lines_to_grid(std::string(lib::sample_data()));
+    ASSERT_TRUE(cells::trace_exceeds(grid, {0, 0}, cells::Direction::Right, 45));
+    ASSERT_FALSE(cells::trace_exceeds(grid, {0, 0}, cells::Direction::Right, 46));
+    ASSERT_FALSE(cells::trace_exceeds(grid, {-1, 0}, cells::Direction::Right, 0));
+
+    auto random = lib::random_grid(30, 20, 0.1, 3);
+    for (cells::Coord y = 0; y < random.height(); ++y)
+    {
+        auto count = cells::trace_grid(random, {0, y}, cells::Direction::Right);
+        ASSERT_TRUE(cells::trace_exceeds(random, {0, y}, cells::Direction::Right, count - 1));
+        ASSERT_FALSE(cells::trace_exceeds(random, {0, y}, cells::Direction::Right, count));
+    }
+}
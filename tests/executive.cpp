@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include <deque>
+#include "executive.h"
+
+using namespace state_machine;
+
+TEST(Executive, IdleBehaviorsAreSkipped)
+{
+    Executive executive;
+    std::deque<ScheduledButtonBehavior> behaviors;
+    for (int i = 0; i < 1000; ++i)
+    {
+        executive.add(behaviors.emplace_back(executive));
+    }
+
+    // Every behavior runs once to find out what it waits on
+    executive.frame(0.0);
+    ASSERT_EQ(executive.runs(), 1000);
+
+    // Nothing changed, nothing runs
+    for (int frame = 1; frame < 100; ++frame)
+    {
+        executive.frame(frame * 0.1);
+    }
+    ASSERT_EQ(executive.runs(), 1000);
+
+    // A single press only runs the pressed behavior
+    behaviors[42].io.set_button(true);
+    executive.frame(10.0);
+    ASSERT_EQ(executive.runs(), 1001);
+    ASSERT_EQ(behaviors[42].io.light_value, OnOff::On);
+    ASSERT_EQ(behaviors[42].behavior.get_state(), PolledButtonBehavior::States::BlinkOn);
+}
+
+TEST(Executive, TimerExpiryWakesBlinkingBehavior)
+{
+    Executive executive;
+    ScheduledButtonBehavior behavior(executive);
+    executive.add(behavior);
+    executive.frame(0.0);
+
+    behavior.io.set_button(true);
+    executive.frame(0.0);
+    ASSERT_EQ(behavior.io.light_value, OnOff::On);
+    auto runs = executive.runs();
+
+    // Frames before the deadline do not run it
+    executive.frame(0.5);
+    executive.frame(0.9);
+    ASSERT_EQ(executive.runs(), runs);
+
+    executive.frame(1.0);
+    ASSERT_EQ(executive.runs(), runs + 1);
+    ASSERT_EQ(behavior.io.light_value, OnOff::Off);
+    ASSERT_EQ(behavior.behavior.get_state(), PolledButtonBehavior::States::BlinkOff);
+
+    // Release goes through ReleasedButton and settles in NotPressed
+    behavior.io.set_button(false);
+    executive.frame(1.5);
+    executive.frame(1.6);
+    ASSERT_EQ(behavior.io.light_value, OnOff::Off);
+    ASSERT_EQ(behavior.behavior.get_state(), PolledButtonBehavior::States::NotPressed);
+
+    // The stale timer subscription does not wake it
+    runs = executive.runs();
+    executive.frame(3.0);
+    ASSERT_EQ(executive.runs(), runs);
+}
+
+TEST(Executive, EdgesOnlySignalOnChange)
+{
+    Executive executive;
+    LatchedButtonIO io(executive);
+    ASSERT_EQ(executive.version(io.button_signal()), 0);
+    io.set_button(false);
+    ASSERT_EQ(executive.version(io.button_signal()), 0);
+    io.set_button(true);
+    auto version = executive.version(io.button_signal());
+    ASSERT_GT(version, 0);
+    io.set_button(true);
+    ASSERT_EQ(executive.version(io.button_signal()), version);
+}
+
+TEST(Executive, WaitSetRejectsSignalsPastCapacity)
+{
+    WaitSet set;
+    for (SignalId signal = 0; signal < WaitSet::capacity; ++signal)
+    {
+        set.add(signal);
+    }
+    ASSERT_THROW(set.add(WaitSet::capacity), std::runtime_error);
+    ASSERT_EQ(static_cast<std::size_t>(set.end() - set.begin()), WaitSet::capacity);
+    set.clear();
+    set.add(7);
+    ASSERT_EQ(*set.begin(), 7);
+}
+
+TEST(Executive, UnfiredSignalsDoNotAccumulateWaiters)
+{
+    Executive executive;
+    ScheduledButtonBehavior behavior(executive);
+    executive.add(behavior);
+    executive.frame(0.0);
+
+    // Held down, it blinks on its timer and re-subscribes to the button every wake
+    behavior.io.set_button(true);
+    for (int frame = 0; frame < 10000; ++frame)
+    {
+        executive.frame(frame * 1.0);
+    }
+    ASSERT_GT(executive.runs(), 5000);
+    ASSERT_LE(executive.waiter_count(behavior.io.button_signal()), 2);
+}
@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+#include <deque>
+#include <stdexcept>
+#include <vector>
+#include "fiber.h"
+#include "simulation.h"
+
+using namespace state_machine;
+
+TEST(Fiber, RoundsInterleaveFibers)
+{
+    FiberScheduler scheduler;
+    std::vector<int> order;
+    for (int id = 0; id < 3; ++id)
+    {
+        scheduler.spawn([&order, id]
+                        {
+            for (int step = 0; step < 2; ++step)
+            {
+                order.push_back(id * 10 + step);
+                FiberScheduler::yield();
+            } });
+    }
+    ASSERT_EQ(scheduler.round(), 3);
+    ASSERT_EQ(scheduler.round(), 3);
+    ASSERT_EQ(scheduler.round(), 0);
+    ASSERT_EQ(order, (std::vector<int>{0, 10, 20, 1, 11, 21}));
+    // Finished fibers hand their stacks back for reuse
+    scheduler.spawn([] {});
+    ASSERT_EQ(scheduler.round(), 0);
+    ASSERT_EQ(scheduler.stacks().mapped(), 3);
+}
+
+TEST(Fiber, YieldOutsideFiberThrows)
+{
+    ASSERT_THROW(FiberScheduler::yield(), std::runtime_error);
+}
+
+TEST(Fiber, DestroyingSchedulerUnwindsRunningFibers)
+{
+    struct Flag
+    {
+        bool &flag;
+        ~Flag()
+        {
+            flag = true;
+        }
+    };
+    bool unwound = false;
+    bool never_started = false;
+    {
+        FiberScheduler scheduler;
+        scheduler.spawn([&]
+                        {
+            Flag flag{unwound};
+            while (true)
+            {
+                FiberScheduler::yield();
+            } });
+        scheduler.round();
+        scheduler.spawn([&]
+                        { never_started = true; });
+    }
+    ASSERT_TRUE(unwound);
+    ASSERT_FALSE(never_started);
+}
+
+TEST(Fiber, BlockingStartMatchesPolledBehavior)
+{
+    VirtualClock clock;
+    SimIO fiber_io(clock);
+    SimTimer fiber_timer(clock);
+    SimIO polled_io(clock);
+    SimTimer polled_timer(clock);
+    PolledButtonBehavior polled(polled_io, polled_timer);
+
+    FiberScheduler scheduler;
+    FiberIO io(scheduler, fiber_io);
+    FiberTimer timer(scheduler, fiber_timer);
+    // The unmodified blocking entry point, which never returns
+    scheduler.spawn([&]
+                    { start(io, timer); });
+
+    const double frame = 0.25;
+    for (int step = 0; step < 200; ++step)
+    {
+        clock.advance_to(step * frame);
+        // Hold for a varying number of blinks, then release for a while
+        bool pressed = (step % 37) > 5 && (step % 37) < 5 + step % 23;
+        fiber_io.button_pressed_value = pressed;
+        polled_io.button_pressed_value = pressed;
+        scheduler.round();
+        polled.do_work();
+    }
+    ASSERT_GT(polled_io.trace.size(), 10);
+    ASSERT_EQ(fiber_io.trace, polled_io.trace);
+}
+
+TEST(Fiber, ThousandsOfBlockingBehaviorsShareOneThread)
+{
+    const std::size_t count = 2000;
+    VirtualClock clock;
+    FiberScheduler scheduler(16 * 1024);
+    std::deque<SimIO> sim_io;
+    std::deque<SimTimer> sim_timers;
+    std::deque<FiberIO> io;
+    std::deque<FiberTimer> timers;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        auto &fiber_io = io.emplace_back(scheduler, sim_io.emplace_back(clock));
+        auto &fiber_timer = timers.emplace_back(scheduler, sim_timers.emplace_back(clock));
+        scheduler.spawn([&]
+                        { start(fiber_io, fiber_timer); });
+    }
+    for (int step = 0; step < 20; ++step)
+    {
+        clock.advance_to(step * 0.5);
+        for (auto &sim : sim_io)
+        {
+            sim.button_pressed_value = step >= 2;
+        }
+        ASSERT_EQ(scheduler.round(), count);
+    }
+    // Pressed at t=1, toggling every second after that
+    for (const auto &sim : sim_io)
+    {
+        ASSERT_EQ(sim.trace.size(), 9);
+        ASSERT_EQ(sim.trace.front(), (LightSample{1.0, OnOff::On}));
+    }
+    ASSERT_EQ(scheduler.stacks().mapped(), count);
+}
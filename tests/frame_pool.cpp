@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+#include <optional>
+#include <vector>
+#include "frame_pool.h"
+
+using namespace state_machine;
+
+TEST(FramePool, PolledAsyncBehavior)
+{
+    FramePool pool;
+    bool value = false;
+    bool started = false;
+    bool exited = false;
+    int loop_count = 0;
+    auto body = [&]() -> FrameTask
+    {
+        started = true;
+        while (!value)
+        {
+            co_await pool.next_frame();
+            loop_count++;
+        }
+        exited = true;
+    };
+    auto task = body();
+    ASSERT_FALSE(started);
+
+    // Starting runs until the first yield
+    task.resume();
+    ASSERT_TRUE(started);
+    ASSERT_EQ(pool.size(), 1);
+    ASSERT_EQ(loop_count, 0);
+
+    ASSERT_EQ(pool.frame(), 1);
+    ASSERT_EQ(loop_count, 1);
+    ASSERT_EQ(pool.frame(), 1);
+    ASSERT_EQ(loop_count, 2);
+
+    value = true;
+    ASSERT_EQ(pool.frame(), 1);
+    ASSERT_TRUE(exited);
+    ASSERT_TRUE(task.done());
+    ASSERT_TRUE(pool.empty());
+    ASSERT_EQ(pool.frame(), 0);
+}
+
+TEST(FramePool, OwnerResumeIsIgnoredWhileParked)
+{
+    FramePool pool;
+    int steps = 0;
+    auto body = [&]() -> FrameTask
+    {
+        for (;;)
+        {
+            steps++;
+            co_await pool.next_frame();
+        }
+    };
+    auto task = body();
+    task.resume();
+    ASSERT_EQ(steps, 1);
+    task.resume();
+    task.resume();
+    ASSERT_EQ(steps, 1);
+    pool.frame();
+    ASSERT_EQ(steps, 2);
+}
+
+TEST(FramePool, EveryCoroutineResumesOncePerFrame)
+{
+    FramePool pool;
+    std::vector<int> frames(1000, 0);
+    auto body = [&](std::size_t index) -> FrameTask
+    {
+        for (;;)
+        {
+            co_await pool.next_frame();
+            frames[index]++;
+        }
+    };
+    std::vector<FrameTask> tasks;
+    for (std::size_t i = 0; i < frames.size(); ++i)
+    {
+        tasks.push_back(body(i));
+        tasks.back().resume();
+    }
+    ASSERT_EQ(pool.size(), frames.size());
+    for (int frame = 1; frame <= 3; ++frame)
+    {
+        ASSERT_EQ(pool.frame(), frames.size());
+        for (auto count : frames)
+        {
+            ASSERT_EQ(count, frame);
+        }
+    }
+}
+
+TEST(FramePool, DestroyingParkedCoroutineUnlinksIt)
+{
+    FramePool pool;
+    int a_runs = 0;
+    int b_runs = 0;
+    auto body = [&](int &runs) -> FrameTask
+    {
+        for (;;)
+        {
+            co_await pool.next_frame();
+            runs++;
+        }
+    };
+    std::optional<FrameTask> a;
+    a.emplace(body(a_runs));
+    auto b = body(b_runs);
+    a->resume();
+    b.resume();
+    ASSERT_EQ(pool.size(), 2);
+
+    a.reset();
+    ASSERT_EQ(pool.size(), 1);
+    ASSERT_EQ(pool.frame(), 1);
+    ASSERT_EQ(a_runs, 0);
+    ASSERT_EQ(b_runs, 1);
+}
+
+TEST(FramePool, CoroutineDestroyedDuringFrameIsSkipped)
+{
+    FramePool pool;
+    std::optional<FrameTask> victim;
+    int victim_runs = 0;
+    auto killer_body = [&]() -> FrameTask
+    {
+        co_await pool.next_frame();
+        victim.reset();
+    };
+    auto victim_body = [&]() -> FrameTask
+    {
+        for (;;)
+        {
+            co_await pool.next_frame();
+            victim_runs++;
+        }
+    };
+    auto killer = killer_body();
+    victim.emplace(victim_body());
+    killer.resume();
+    victim->resume();
+
+    ASSERT_EQ(pool.frame(), 1);
+    ASSERT_TRUE(killer.done());
+    ASSERT_EQ(victim_runs, 0);
+    ASSERT_TRUE(pool.empty());
+}
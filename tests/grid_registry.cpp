@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include <cerrno>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "grid_registry.h"
+#include "lib.h"
+
+static std::string test_prefix()
+{
+    return "cells_test_" + std::to_string(::getpid());
+}
+
+TEST(GridRegistry, PublishOpenAndCountReaders)
+{
+    cells::GridRegistry registry(test_prefix());
+    ASSERT_EQ(registry.current_version("sample"), 0);
+    ASSERT_THROW(registry.open("sample"), std::runtime_error);
+
+    auto sample = lib::lines_to_grid(std::string(lib::sample_data()));
+    ASSERT_EQ(registry.publish("sample", sample, 4), 1);
+    {
+        auto first = registry.open("sample");
+        auto second = registry.open("sample");
+        ASSERT_EQ(first.version(), 1);
+        ASSERT_EQ(first.readers(), 2);
+        ASSERT_EQ(first.grid().width(), 10);
+        ASSERT_EQ(cells::trace_grid(second.grid(), {0, 0}, cells::Direction::Right), 46);
+    }
+    ASSERT_EQ(registry.open("sample").readers(), 1);
+    registry.remove("sample");
+    ASSERT_EQ(registry.current_version("sample"), 0);
+}
+
+TEST(GridRegistry, NewVersionsLeaveOpenReadersAlone)
+{
+    cells::GridRegistry registry(test_prefix());
+    auto sample = lib::lines_to_grid(std::string(lib::sample_data()));
+    auto other = lib::random_grid(17, 5, 0.3, 2);
+    registry.publish("grid", sample);
+    auto old = registry.open("grid");
+
+    ASSERT_EQ(registry.publish("grid", other), 2);
+    ASSERT_EQ(registry.current_version("grid"), 2);
+    auto current = registry.open("grid");
+    ASSERT_EQ(current.version(), 2);
+    ASSERT_EQ(current.readers(), 1);
+    ASSERT_EQ(current.grid().width(), 17);
+
+    // The replaced version is unlinked but still mapped
+    ASSERT_EQ(old.version(), 1);
+    ASSERT_EQ(cells::trace_grid(old.grid(), {0, 0}, cells::Direction::Right), 46);
+    registry.remove("grid");
+}
+
+TEST(GridRegistry, OtherProcessesShareTheSegment)
+{
+    auto prefix = test_prefix();
+    cells::GridRegistry registry(prefix);
+    registry.publish("shared", lib::lines_to_grid(std::string(lib::sample_data())));
+    auto parent = registry.open("shared");
+
+    auto child = ::fork();
+    ASSERT_GE(child, 0);
+    if (child == 0)
+    {
+        // Child: a fresh registry object sees the parent's grid and its reader
+        bool ok = false;
+        try
+        {
+            auto grid = cells::GridRegistry(prefix).open("shared");
+            ok = grid.readers() == 2 && cells::trace_grid(grid.grid(), {3, 0}, cells::Direction::Down) == 51;
+        }
+        catch (const std::exception &)
+        {
+        }
+        ::_exit(ok ? 0 : 1);
+    }
+    int status = 0;
+    ::waitpid(child, &status, 0);
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(WEXITSTATUS(status), 0);
+    ASSERT_EQ(parent.readers(), 1);
+    registry.remove("shared");
+}
+
+TEST(GridRegistry, FailedPublishLeavesNoSegments)
+{
+    auto prefix = test_prefix();
+    cells::GridRegistry registry(prefix);
+    // Something already holds the name version 1 would get
+    auto squatter = "/" + prefix + ".taken.1";
+    int fd = ::shm_open(squatter.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    ASSERT_GE(fd, 0);
+    ::close(fd);
+
+    ASSERT_THROW(registry.publish("taken", lib::lines_to_grid(std::string(lib::sample_data()))), std::runtime_error);
+    ASSERT_EQ(registry.current_version("taken"), 0);
+    fd = ::shm_open((squatter + ".readers").c_str(), O_RDONLY, 0);
+    ASSERT_LT(fd, 0);
+    ASSERT_EQ(errno, ENOENT);
+
+    // The next version publishes normally
+    ASSERT_EQ(registry.publish("taken", lib::lines_to_grid(std::string(lib::sample_data()))), 2);
+    registry.remove("taken");
+    ::shm_unlink(squatter.c_str());
+}
+
+TEST(GridRegistry, OtherUsersOpenReadOnly)
+{
+    if (::geteuid() != 0)
+    {
+        GTEST_SKIP() << "needs root to switch to another user";
+    }
+    auto prefix = test_prefix();
+    cells::GridRegistry registry(prefix);
+    registry.publish("public", lib::lines_to_grid(std::string(lib::sample_data())));
+
+    auto child = ::fork();
+    ASSERT_GE(child, 0);
+    if (child == 0)
+    {
+        bool ok = false;
+        try
+        {
+            // nobody, with neither write access to the grid nor any privileges
+            if (::setgid(65534) == 0 && ::setuid(65534) == 0)
+            {
+                auto grid = cells::GridRegistry(prefix).open("public");
+                ok = grid.readers() == 1 && cells::trace_grid(grid.grid(), {0, 0}, cells::Direction::Right) == 46;
+            }
+        }
+        catch (const std::exception &)
+        {
+        }
+        ::_exit(ok ? 0 : 1);
+    }
+    int status = 0;
+    ::waitpid(child, &status, 0);
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(WEXITSTATUS(status), 0);
+    ASSERT_EQ(registry.open("public").readers(), 1);
+    registry.remove("public");
+}
@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "grid_snapshot.h"
+#include "lib.h"
+
+TEST(GridSnapshot, MatchesSourceGrid)
+{
+    auto grid = lib::random_grid(37, 21, 0.2, 5);
+    cells::GridEditor editor(grid, 8);
+    auto snapshot = editor.current();
+    ASSERT_EQ(snapshot->version(), 1);
+    ASSERT_EQ(snapshot->tile_count(), 5 * 3);
+    for (cells::Coord y = -1; y <= grid.height(); ++y)
+    {
+        for (cells::Coord x = -1; x <= grid.width(); ++x)
+        {
+            ASSERT_EQ(snapshot->at(x, y), grid.at(x, y));
+        }
+    }
+    for (cells::Coord y = 0; y < grid.height(); ++y)
+    {
+        ASSERT_EQ(cells::trace_grid(*snapshot, {0, y}, cells::Direction::Right), cells::trace_grid(grid, {0, y}, cells::Direction::Right));
+    }
+}
+
+TEST(GridSnapshot, EditsCopyOnlyTheirTiles)
+{
+    auto sample = lib::lines_to_grid(std::string(lib::sample_data()));
+    cells::GridEditor editor(sample, 4);
+    auto before = editor.current();
+
+    // Two edits in the top left tile, one in the bottom right
+    editor.set(0, 0, cells::Cell::Backslash);
+    editor.set(1, 0, cells::Cell::Slash);
+    editor.set(9, 9, cells::Cell::Vertical);
+    ASSERT_EQ(editor.copied_tiles(), 2);
+    ASSERT_EQ(editor.current(), before);
+    ASSERT_THROW(editor.set(10, 0, cells::Cell::Space), std::runtime_error);
+
+    auto after = editor.publish();
+    ASSERT_EQ(after->version(), 2);
+    ASSERT_EQ(editor.current(), after);
+    ASSERT_EQ(editor.copied_tiles(), 0);
+    for (std::size_t tile = 0; tile < after->tile_count(); ++tile)
+    {
+        ASSERT_EQ(after->shares_tile(*before, tile), tile != 0 && tile != after->tile_count() - 1) << tile;
+    }
+
+    // The old version is untouched
+    ASSERT_EQ(before->at(0, 0), cells::Cell::Space);
+    ASSERT_EQ(cells::trace_grid(*before, {0, 0}, cells::Direction::Right), 46);
+    ASSERT_EQ(after->at(0, 0), cells::Cell::Backslash);
+    ASSERT_EQ(cells::trace_grid(*after, {0, 0}, cells::Direction::Right), cells::trace_grid(sample, {0, 1}, cells::Direction::Down) + 1);
+}
+
+TEST(GridSnapshot, ReadersSeeWholeVersions)
+{
+    const cells::Coord size = 64;
+    cells::GridEditor editor(lib::random_grid(size, size, 0.1, 9), 16);
+    std::atomic<bool> done = false;
+    std::atomic<std::size_t> torn = 0;
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i)
+    {
+        readers.emplace_back([&]
+                             {
+            while (!done)
+            {
+                // Opposite corners, in different tiles, always change together
+                auto snapshot = editor.current();
+                if (snapshot->at(0, 0) != snapshot->at(size - 1, size - 1))
+                {
+                    torn++;
+                }
+                cells::trace_grid(*snapshot, {0, 0}, cells::Direction::Right);
+            } });
+    }
+    for (int version = 0; version < 200; ++version)
+    {
+        auto cell = version % 2 ? cells::Cell::Slash : cells::Cell::Backslash;
+        editor.set(0, 0, cell);
+        editor.set(size - 1, size - 1, cell);
+        editor.publish();
+    }
+    done = true;
+    for (auto &reader : readers)
+    {
+        reader.join();
+    }
+    ASSERT_EQ(torn, 0);
+    ASSERT_EQ(editor.current()->version(), 201);
+}
@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <unistd.h>
+#include <fstream>
+#include <string>
+#include "lib.h"
+#include "mapped_grid.h"
+
+static std::string temp_path(const std::string &name)
+{
+    return (std::filesystem::temp_directory_path() / ("mapped_grid_" + name + "_" + std::to_string(::getpid()))).string();
+}
+
+TEST(MappedGrid, CellsMatchAcrossTiles)
+{
+    auto grid = lib::lines_to_grid(std::string(lib::sample_data()));
+    auto path = temp_path("cells");
+    // 4x4 tiles split the 10x10 sample with padding on the right and bottom
+    cells::write_tile_file(path, grid, 4);
+    {
+        cells::MappedGrid mapped(path);
+        ASSERT_EQ(mapped.width(), 10);
+        ASSERT_EQ(mapped.height(), 10);
+        ASSERT_EQ(mapped.padded_cells(), 144);
+        for (cells::Coord y = -1; y <= grid.height(); ++y)
+        {
+            for (cells::Coord x = -1; x <= grid.width(); ++x)
+            {
+                ASSERT_EQ(mapped.at(x, y), grid.at(x, y));
+            }
+        }
+    }
+    std::filesystem::remove(path);
+}
+
+TEST(MappedGrid, TraceMatchesDenseGrid)
+{
+    for (unsigned seed = 0; seed < 6; ++seed)
+    {
+        auto grid = seed == 0 ? lib::lines_to_grid(std::string(lib::sample_data())) : lib::random_grid(37, 29, 0.1, seed);
+        auto path = temp_path("trace");
+        cells::write_tile_file(path, grid, 8);
+        cells::MappedGrid mapped(path);
+        for (cells::Coord y = 0; y < grid.height(); ++y)
+        {
+            ASSERT_EQ(cells::trace_grid(mapped, {0, y}, cells::Direction::Right), cells::trace_grid(grid, {0, y}, cells::Direction::Right));
+            ASSERT_EQ(cells::trace_grid(mapped, {grid.width() - 1, y}, cells::Direction::Left), cells::trace_grid(grid, {grid.width() - 1, y}, cells::Direction::Left));
+        }
+        for (cells::Coord x = 0; x < grid.width(); ++x)
+        {
+            ASSERT_EQ(cells::trace_grid(mapped, {x, 0}, cells::Direction::Down), cells::trace_grid(grid, {x, 0}, cells::Direction::Down));
+        }
+        std::filesystem::remove(path);
+    }
+}
+
+TEST(MappedGrid, HugeSparseFileUses64BitIndexing)
+{
+    // One long strip of 4096x4096 tiles pads out past 2^32 cells, and a header
+    // plus a sparse file extension gets there without writing 4GB
+    const std::uint64_t width = 1'050'000;
+    const std::uint64_t height = 3;
+    const std::uint32_t tile = 4096;
+    auto path = temp_path("huge");
+    {
+        cells::TileFileHeader header{};
+        std::memcpy(header.magic, "BEAMGRID", 8);
+        header.width = width;
+        header.height = height;
+        header.tile_size = tile;
+        std::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    }
+    const std::uint64_t tiles = (width + tile - 1) / tile;
+    std::filesystem::resize_file(path, sizeof(cells::TileFileHeader) + tiles * tile * tile);
+
+    cells::MappedGrid mapped(path);
+    ASSERT_GT(mapped.padded_cells(), std::numeric_limits<std::uint32_t>::max());
+    ASSERT_EQ(mapped.at(width - 1, height - 1), cells::Cell::Space);
+    ASSERT_FALSE(mapped.at(width, 0));
+    // The last cell is the last byte of the last tile
+    ASSERT_EQ(mapped.cell_index<std::uint64_t>(tiles * tile - 1, tile - 1), mapped.padded_cells() - 1);
+
+    ASSERT_EQ(cells::trace_grid(mapped, {0, 1}, cells::Direction::Right), width);
+    ASSERT_EQ(cells::trace_grid(mapped, {width - 1, 2}, cells::Direction::Left), width);
+    ASSERT_EQ(cells::trace_grid(mapped, {777'777, height - 1}, cells::Direction::Up), height);
+    std::filesystem::remove(path);
+}
+
+TEST(MappedGrid, RejectsOtherFiles)
+{
+    auto path = temp_path("bad");
+    {
+        std::ofstream file(path);
+        file << "definitely not a grid, but longer than a header is";
+    }
+    ASSERT_THROW(cells::MappedGrid mapped(path), std::runtime_error);
+    std::filesystem::remove(path);
+    ASSERT_THROW(cells::MappedGrid mapped(path), std::runtime_error);
+}
+
+TEST(MappedGrid, RejectsCraftedHeadersAndCells)
+{
+    auto path = temp_path("crafted");
+    cells::write_tile_file(path, lib::lines_to_grid(std::string(lib::sample_data())), 4);
+    auto patch = [&](std::size_t offset, const void *bytes, std::size_t size)
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(static_cast<std::streamoff>(offset));
+        file.write(static_cast<const char *>(bytes), static_cast<std::streamsize>(size));
+    };
+
+    // A bad cell byte is caught when it is read, in at() or while tracing
+    const std::uint8_t bad_cell = 9;
+    patch(sizeof(cells::TileFileHeader) + 1, &bad_cell, 1);
+    {
+        cells::MappedGrid mapped(path);
+        ASSERT_THROW(mapped.at(1, 0), std::runtime_error);
+        ASSERT_THROW(cells::trace_grid(mapped, {0, 0}, cells::Direction::Right), std::runtime_error);
+    }
+
+    // Sizes whose padded cell count wraps around 64 bits
+    cells::TileFileHeader header;
+    {
+        std::ifstream file(path, std::ios::binary);
+        file.read(reinterpret_cast<char *>(&header), sizeof(header));
+    }
+    header.width = std::uint64_t(1) << 62;
+    header.height = 1;
+    header.tile_size = std::uint32_t(1) << 31;
+    patch(0, &header, sizeof(header));
+    ASSERT_THROW(cells::MappedGrid mapped(path), std::runtime_error);
+    ASSERT_THROW(cells::tile_image_size(cells::Coord(1) << 62, cells::Coord(1) << 62, 1), std::runtime_error);
+    std::filesystem::remove(path);
+}
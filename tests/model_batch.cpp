@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+#include "model_batch.h"
+
+using namespace clarity;
+
+TEST(ModelBatch, BitmapMatchesModels)
+{
+    std::mt19937 random(1234);
+    std::vector<Model> models;
+    ModelBatch batch;
+
+    // Not a multiple of 64, so the padding in the last word is exercised
+    for (int i = 0; i < 1000; ++i)
+    {
+        auto &model = models.emplace_back();
+        auto index = batch.add();
+        bool power = random() % 8 != 0;
+        int states = random() % 16 == 0 ? 0 : 2;
+        model.turnPowerOn(power);
+        batch.turnPowerOn(index, power);
+        model.setStates(states);
+        batch.setStates(index, states);
+        model.setOtherValues(1);
+        batch.setOtherValues(index, 1);
+        if (random() % 4 == 0)
+        {
+            auto field = random() % NUM_OTHER_VALUES;
+            model.setOtherValue(field, 0);
+            batch.setOtherValue(index, field, 0);
+        }
+    }
+
+    auto bitmap = batch.validate();
+    ASSERT_EQ(bitmap.size(), 16);
+    std::size_t valid = 0;
+    for (std::size_t i = 0; i < models.size(); ++i)
+    {
+        ASSERT_EQ(is_set(bitmap, i), models[i].isValid()) << "model " << i;
+        ASSERT_EQ(batch.isValid(i), models[i].isValid()) << "model " << i;
+        valid += models[i].isValid();
+    }
+    // Padding models are never valid
+    ASSERT_EQ(bitmap.back() >> (1000 % 64), 0);
+    ASSERT_GT(valid, 0);
+    ASSERT_LT(valid, models.size());
+}
+
+TEST(ModelBatch, GrowingKeepsFields)
+{
+    ModelBatch batch(2);
+    auto first = batch.add();
+    batch.turnPowerOn(first);
+    batch.setStates(first, 1);
+    batch.setOtherValues(first, 1);
+    for (int i = 0; i < 200; ++i)
+    {
+        batch.add();
+    }
+    auto bitmap = batch.validate();
+    ASSERT_TRUE(is_set(bitmap, first));
+    ASSERT_FALSE(is_set(bitmap, first + 1));
+}
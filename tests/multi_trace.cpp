@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <stdexcept>
+#include "lib.h"
+#include "multi_trace.h"
+
+static std::vector<std::size_t> trace_each(const cells::Grid &grid, const std::vector<cells::Entry> &entries)
+{
+    std::vector<std::size_t> results;
+    for (const auto &entry : entries)
+    {
+        results.push_back(cells::trace_grid(grid, entry.location, entry.direction));
+    }
+    return results;
+}
+
+TEST(MultiTrace, EdgeEntriesCoverEveryBorderCell)
+{
+    auto entries = cells::edge_entries(3, 2);
+    ASSERT_EQ(entries.size(), 10);
+    ASSERT_EQ(entries.front(), (cells::Entry{{0, 0}, cells::Direction::Down}));
+    ASSERT_EQ(entries.back(), (cells::Entry{{2, 1}, cells::Direction::Left}));
+    ASSERT_TRUE(cells::edge_entries(0, 5).empty());
+}
+
+TEST(MultiTrace, SampleEdgesMatchSingleTraces)
+{
+    auto grid = lib::lines_to_grid(std::string(lib::sample_data()));
+    auto entries = cells::edge_entries(grid.width(), grid.height());
+    auto expected = trace_each(grid, entries);
+    ASSERT_EQ(cells::trace_entries(grid, entries, 64), expected);
+    ASSERT_EQ(cells::trace_entries(grid, entries, 256), expected);
+    ASSERT_EQ(*std::max_element(expected.begin(), expected.end()), 51);
+}
+
+TEST(MultiTrace, RandomGridsAcrossSeveralPasses)
+{
+    for (unsigned seed = 1; seed < 5; ++seed)
+    {
+        // 2 * (40 + 25) = 130 entries, several 64 lane passes and one partial 256 lane pass
+        auto grid = lib::random_grid(40, 25, 0.08 * seed, seed);
+        auto entries = cells::edge_entries(grid.width(), grid.height());
+        // Interior and off grid entries are traced too
+        entries.push_back({{20, 12}, cells::Direction::Left});
+        entries.push_back({{-1, 3}, cells::Direction::Right});
+        auto expected = trace_each(grid, entries);
+        ASSERT_EQ(expected.back(), 0);
+        ASSERT_EQ(cells::trace_entries(grid, entries, 64), expected);
+        ASSERT_EQ(cells::trace_entries(grid, entries, 256), expected);
+        ASSERT_EQ(cells::trace_entries(grid, entries), expected);
+    }
+}
+
+TEST(MultiTrace, RejectsOtherLaneCounts)
+{
+    auto grid = lib::random_grid(4, 4, 0.5, 1);
+    auto entries = cells::edge_entries(4, 4);
+    ASSERT_THROW(cells::trace_entries(grid, entries, 128), std::runtime_error);
+}
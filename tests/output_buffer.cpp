@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+#include <deque>
+#include "output_buffer.h"
+
+using namespace state_machine;
+
+class ButtonIO : public IIO
+{
+public:
+    void set_light(OnOff) override {}
+    bool button_pressed() override
+    {
+        return button_pressed_value;
+    }
+    bool button_released() override
+    {
+        return !button_pressed_value;
+    }
+    bool button_pressed_value = false;
+};
+
+class ImmediateTimer : public ITimer
+{
+public:
+    ITimer &reset(double) override
+    {
+        expired_value = false;
+        return *this;
+    }
+    bool expired() const override
+    {
+        return expired_value;
+    }
+    bool expired_value = false;
+};
+
+TEST(OutputBuffer, RedundantWritesAreDropped)
+{
+    SimulatedBus bus;
+    OutputBuffer buffer(bus);
+    auto channel = buffer.add_channel();
+
+    // Already off on the bus
+    buffer.set(channel, OnOff::Off);
+    ASSERT_EQ(buffer.flush(), 0);
+    ASSERT_EQ(bus.transactions, 0);
+
+    // On then back off within a frame is not a change
+    buffer.set(channel, OnOff::On);
+    buffer.set(channel, OnOff::Off);
+    ASSERT_EQ(buffer.flush(), 0);
+
+    buffer.set(channel, OnOff::On);
+    buffer.set(channel, OnOff::On);
+    ASSERT_EQ(buffer.flush(), 1);
+    ASSERT_EQ(bus.transactions, 1);
+    ASSERT_EQ(bus.values[channel], OnOff::On);
+}
+
+TEST(OutputBuffer, FrameIsFlushedInOneTransaction)
+{
+    SimulatedBus bus;
+    OutputBuffer buffer(bus);
+
+    struct Instance
+    {
+        Instance(OutputBuffer &buffer) : io(input, buffer), behavior(io, timer) {}
+        ButtonIO input;
+        ImmediateTimer timer;
+        BufferedLightIO io;
+        PolledButtonBehavior behavior;
+    };
+    std::deque<Instance> instances;
+    for (int i = 0; i < 50; ++i)
+    {
+        instances.emplace_back(buffer);
+    }
+
+    // Idle frame, nothing goes out
+    for (auto &instance : instances)
+    {
+        instance.behavior.do_work();
+    }
+    buffer.flush();
+    ASSERT_EQ(bus.transactions, 0);
+
+    // Press every button, all lights turn on with a single transaction
+    for (auto &instance : instances)
+    {
+        instance.input.button_pressed_value = true;
+        instance.behavior.do_work();
+    }
+    ASSERT_EQ(buffer.flush(), 50);
+    ASSERT_EQ(bus.transactions, 1);
+    ASSERT_EQ(bus.writes, 50);
+
+    // Release, every light goes off again in one transaction
+    for (auto &instance : instances)
+    {
+        instance.input.button_pressed_value = false;
+        instance.behavior.do_work();
+        ASSERT_EQ(instance.behavior.get_state(), PolledButtonBehavior::States::NotPressed);
+    }
+    ASSERT_EQ(buffer.flush(), 50);
+    ASSERT_EQ(bus.transactions, 2);
+    ASSERT_EQ(bus.writes, 100);
+    ASSERT_EQ(bus.values[instances[7].io.channel()], OnOff::Off);
+}
+
+TEST(OutputBuffer, ReleaseDuringBlinkOffWritesNothing)
+{
+    SimulatedBus bus;
+    OutputBuffer buffer(bus);
+    ButtonIO input;
+    ImmediateTimer timer;
+    BufferedLightIO io(input, buffer);
+    PolledButtonBehavior behavior(io, timer);
+
+    input.button_pressed_value = true;
+    behavior.do_work();
+    ASSERT_EQ(buffer.flush(), 1);
+
+    // The blink timer runs out and the light goes off
+    timer.expired_value = true;
+    behavior.do_work();
+    ASSERT_EQ(behavior.get_state(), PolledButtonBehavior::States::BlinkOff);
+    ASSERT_EQ(buffer.flush(), 1);
+    ASSERT_EQ(bus.writes, 2);
+
+    // Releasing now sets the light off again, which the bus already has
+    input.button_pressed_value = false;
+    behavior.do_work();
+    ASSERT_EQ(behavior.get_state(), PolledButtonBehavior::States::NotPressed);
+    ASSERT_EQ(buffer.flush(), 0);
+    ASSERT_EQ(bus.writes, 2);
+    ASSERT_EQ(bus.transactions, 2);
+    ASSERT_EQ(bus.values[io.channel()], OnOff::Off);
+}
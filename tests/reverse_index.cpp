@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+#include "lib.h"
+#include "reverse_index.h"
+
+/// Forward flood over the same beam states trace_grid visits
+static bool energizes(const cells::Grid &grid, const cells::Entry &entry, cells::Coord x, cells::Coord y)
+{
+    std::vector<std::vector<int>> seen(grid.height(), std::vector<int>(grid.width(), 0));
+    std::vector<cells::Beam> beams = {cells::Beam(entry.location, entry.direction)};
+    while (!beams.empty())
+    {
+        auto beam = beams.back();
+        beams.pop_back();
+        auto [bx, by] = beam.location;
+        auto cell = grid.at(bx, by);
+        if (!cell)
+        {
+            continue;
+        }
+        auto bit = 1 << static_cast<int>(beam.direction);
+        if (seen[by][bx] & bit)
+        {
+            continue;
+        }
+        seen[by][bx] |= bit;
+        for (auto next : cells::next_possible_beams(*cell, beam.direction, beam.location))
+        {
+            beams.push_back(next);
+        }
+    }
+    return seen[y][x] != 0;
+}
+
+static void expect_matches_forward_traces(const cells::Grid &grid)
+{
+    cells::ReverseBeamIndex index(grid);
+    for (cells::Coord y = 0; y < grid.height(); ++y)
+    {
+        for (cells::Coord x = 0; x < grid.width(); ++x)
+        {
+            auto reaching = index.entries_reaching(x, y);
+            ASSERT_EQ(reaching.size(), index.entries().size());
+            for (std::size_t i = 0; i < index.entries().size(); ++i)
+            {
+                ASSERT_EQ(reaching.test(i), energizes(grid, index.entries()[i], x, y)) << x << "," << y << " entry " << i;
+            }
+        }
+    }
+}
+
+TEST(ReverseIndex, SampleMatchesForwardTraces)
+{
+    auto grid = lib::lines_to_grid(std::string(lib::sample_data()));
+    cells::ReverseBeamIndex index(grid);
+    // The top left corner is lit by the entry heading right along the top row
+    auto corner = index.entries_reaching(0, 0);
+    ASSERT_TRUE(corner.test(2 * 10));
+    ASSERT_EQ(index.entries_reaching(-1, 0).count(), 0);
+    expect_matches_forward_traces(grid);
+}
+
+TEST(ReverseIndex, RandomGridsMatchForwardTraces)
+{
+    for (unsigned seed = 1; seed < 4; ++seed)
+    {
+        expect_matches_forward_traces(lib::random_grid(13, 9, 0.15 * seed, seed));
+    }
+}
@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "simulation.h"
+
+using namespace state_machine;
+
+TEST(Simulation, BlinksOncePerSecondWhilePressed)
+{
+    Simulation<> sim;
+    auto index = sim.add_instance();
+    sim.schedule_button(index, 10.0, true);
+    sim.schedule_button(index, 13.5, false);
+    sim.run_until(60.0);
+
+    auto expected = std::vector<LightSample>{
+        {10.0, OnOff::On},
+        {11.0, OnOff::Off},
+        {12.0, OnOff::On},
+        {13.0, OnOff::Off},
+    };
+    ASSERT_EQ(sim[index].io.trace, expected);
+    ASSERT_EQ(sim[index].behavior.get_state(), PolledButtonBehavior::States::NotPressed);
+    ASSERT_EQ(sim.now(), 60.0);
+}
+
+TEST(Simulation, ReleaseDuringBlinkOnTurnsLightOff)
+{
+    Simulation<> sim;
+    auto index = sim.add_instance();
+    sim.schedule_button(index, 1.0, true);
+    sim.schedule_button(index, 1.25, false);
+    sim.run_until(5.0);
+
+    auto expected = std::vector<LightSample>{
+        {1.0, OnOff::On},
+        {1.25, OnOff::Off},
+    };
+    ASSERT_EQ(sim[index].io.trace, expected);
+}
+
+TEST(Simulation, HoursOfManyInstancesJumpBetweenEvents)
+{
+    const std::size_t instances = 100;
+    const double hours = 1.0;
+
+    Simulation<> sim;
+    for (std::size_t i = 0; i < instances; ++i)
+    {
+        auto index = sim.add_instance();
+        // Stagger the presses so every instance has its own deadlines
+        sim.schedule_button(index, static_cast<double>(i + 1) / (instances + 1), true);
+    }
+    sim.run_until(hours * 3600.0);
+
+    for (std::size_t i = 0; i < instances; ++i)
+    {
+        // One toggle per second plus the initial press
+        ASSERT_EQ(sim[i].io.trace.size(), static_cast<std::size_t>(hours * 3600.0));
+    }
+    // Only the event owners were ever run, no idle frames
+    ASSERT_LE(sim.steps(), instances * (1 + 2 * static_cast<std::size_t>(hours * 3600.0)));
+}
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "lib.h"
+#include "sparse_grid.h"
+
+static void expect_all_edges_match(const cells::Grid &grid)
+{
+    cells::SparseGrid sparse(grid);
+    for (int x = 0; x < grid.width(); ++x)
+    {
+        ASSERT_EQ(cells::trace_grid(sparse, {x, 0}, cells::Direction::Down), cells::trace_grid(grid, {x, 0}, cells::Direction::Down));
+        ASSERT_EQ(cells::trace_grid(sparse, {x, grid.height() - 1}, cells::Direction::Up), cells::trace_grid(grid, {x, grid.height() - 1}, cells::Direction::Up));
+    }
+    for (int y = 0; y < grid.height(); ++y)
+    {
+        ASSERT_EQ(cells::trace_grid(sparse, {0, y}, cells::Direction::Right), cells::trace_grid(grid, {0, y}, cells::Direction::Right));
+        ASSERT_EQ(cells::trace_grid(sparse, {grid.width() - 1, y}, cells::Direction::Left), cells::trace_grid(grid, {grid.width() - 1, y}, cells::Direction::Left));
+    }
+}
+
+TEST(SparseGrid, AtMatchesDenseGrid)
+{
+    auto grid = lib::lines_to_grid(std::string(lib::sample_data()));
+    cells::SparseGrid sparse(grid);
+    for (int y = -1; y <= grid.height(); ++y)
+    {
+        for (int x = -1; x <= grid.width(); ++x)
+        {
+            ASSERT_EQ(sparse.at(x, y), grid.at(x, y));
+        }
+    }
+}
+
+TEST(SparseGrid, NextObstacle)
+{
+    auto grid = lib::lines_to_grid(std::string(lib::sample_data()));
+    cells::SparseGrid sparse(grid);
+
+    // Row 0 is .|...\....
+    auto right = sparse.next_obstacle({2, 0}, cells::Direction::Right);
+    ASSERT_TRUE(right);
+    ASSERT_EQ(sparse.obstacle(*right).x, 5);
+    auto left = sparse.next_obstacle({4, 0}, cells::Direction::Left);
+    ASSERT_TRUE(left);
+    ASSERT_EQ(sparse.obstacle(*left).x, 1);
+    // The starting cell counts
+    ASSERT_EQ(sparse.next_obstacle({5, 0}, cells::Direction::Right), right);
+    ASSERT_FALSE(sparse.next_obstacle({6, 0}, cells::Direction::Right));
+    // Column 0 has | at y = 1 only
+    auto down = sparse.next_obstacle({0, 0}, cells::Direction::Down);
+    ASSERT_TRUE(down);
+    ASSERT_EQ(sparse.obstacle(*down).y, 1);
+    ASSERT_FALSE(sparse.next_obstacle({0, 2}, cells::Direction::Down));
+}
+
+TEST(SparseGrid, TraceMatchesSample)
+{
+    auto grid = lib::lines_to_grid(std::string(lib::sample_data()));
+    cells::SparseGrid sparse(grid);
+    ASSERT_EQ(cells::trace_grid(sparse, {0, 0}, cells::Direction::Right), 46);
+    expect_all_edges_match(grid);
+}
+
+TEST(SparseGrid, TraceMatchesRandomGrids)
+{
+    for (unsigned seed = 0; seed < 20; ++seed)
+    {
+        auto density = (seed % 4 + 1) * 0.03;
+        expect_all_edges_match(lib::random_grid(30 + seed, 25, density, seed));
+    }
+}
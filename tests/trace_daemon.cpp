@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include "lib.h"
+#include "trace_daemon.h"
+
+namespace protocol = cells::trace_protocol;
+
+static std::vector<std::uint8_t> load_request(std::uint32_t tag, const std::string &text)
+{
+    std::vector<std::uint8_t> request;
+    protocol::put_header(request, static_cast<std::uint32_t>(text.size()), static_cast<std::uint8_t>(protocol::Op::Load), tag);
+    request.insert(request.end(), text.begin(), text.end());
+    return request;
+}
+
+static std::uint32_t u32_at(const std::vector<std::uint8_t> &bytes, std::size_t offset)
+{
+    std::uint32_t value;
+    std::memcpy(&value, bytes.data() + offset, sizeof(value));
+    return value;
+}
+
+TEST(TraceDaemon, ServiceAnswersCompleteRequestsOnly)
+{
+    cells::TraceService service;
+    auto stream = load_request(7, lib::sample_data());
+    const cells::Entry entries[] = {{{0, 0}, cells::Direction::Right}, {{3, 0}, cells::Direction::Down}};
+    protocol::put_trace(stream, 8, 1, entries);
+
+    // Everything but the last byte: only the load is answered
+    std::vector<std::uint8_t> output;
+    auto consumed = service.handle(std::span(stream).first(stream.size() - 1), output);
+    ASSERT_EQ(consumed, protocol::header_size + std::strlen(lib::sample_data()));
+    ASSERT_EQ(service.grid_count(), 1);
+    ASSERT_EQ(output.size(), protocol::header_size + 4);
+    ASSERT_EQ(output[4], static_cast<std::uint8_t>(protocol::Status::Ok));
+    ASSERT_EQ(u32_at(output, 5), 7);
+    ASSERT_EQ(u32_at(output, 9), 1);
+
+    output.clear();
+    ASSERT_EQ(service.handle(std::span(stream).subspan(consumed), output), stream.size() - consumed);
+    ASSERT_EQ(u32_at(output, 5), 8);
+    std::uint64_t counts[2];
+    ASSERT_EQ(output.size(), protocol::header_size + sizeof(counts));
+    std::memcpy(counts, output.data() + protocol::header_size, sizeof(counts));
+    ASSERT_EQ(counts[0], 46);
+    ASSERT_EQ(counts[1], 51);
+}
+
+TEST(TraceDaemon, ServiceReportsErrors)
+{
+    cells::TraceService service;
+    std::vector<std::uint8_t> stream = load_request(1, "..\n...");
+    const cells::Entry entry{{0, 0}, cells::Direction::Right};
+    protocol::put_trace(stream, 2, 99, std::span(&entry, 1));
+
+    std::vector<std::uint8_t> output;
+    ASSERT_EQ(service.handle(stream, output), stream.size());
+    ASSERT_EQ(service.grid_count(), 0);
+    ASSERT_EQ(output[4], static_cast<std::uint8_t>(protocol::Status::Error));
+    auto second = protocol::header_size + u32_at(output, 0);
+    ASSERT_EQ(output[second + 4], static_cast<std::uint8_t>(protocol::Status::Error));
+    ASSERT_EQ(u32_at(output, second + 5), 2);
+
+    // A length no request can have means the stream is corrupt
+    std::vector<std::uint8_t> corrupt;
+    protocol::put_header(corrupt, protocol::max_payload + 1, 1, 3);
+    ASSERT_THROW(service.handle(corrupt, output), std::runtime_error);
+}
+
+TEST(TraceDaemon, OversizedLoadIsRejected)
+{
+    const std::string five_by_five = ".....\n.|...\n..-..\n...\\.\n.....\n";
+    cells::TraceService service(16);
+    std::vector<std::uint8_t> output;
+    auto stream = load_request(1, five_by_five);
+    ASSERT_EQ(service.handle(stream, output), stream.size());
+    ASSERT_EQ(output[4], static_cast<std::uint8_t>(protocol::Status::Error));
+    ASSERT_EQ(service.grid_count(), 0);
+
+    output.clear();
+    stream = load_request(2, "....\n.|..\n..-.\n....\n");
+    service.handle(stream, output);
+    ASSERT_EQ(output[4], static_cast<std::uint8_t>(protocol::Status::Ok));
+    ASSERT_EQ(service.grid_count(), 1);
+    ASSERT_GT(service.memory_bytes(), 0);
+
+    // Small enough in cells, but its graph does not fit the memory budget
+    cells::TraceService tight(cells::TraceService::default_max_cells, 512);
+    output.clear();
+    stream = load_request(3, lib::sample_data());
+    tight.handle(stream, output);
+    ASSERT_EQ(output[4], static_cast<std::uint8_t>(protocol::Status::Error));
+    ASSERT_EQ(tight.grid_count(), 0);
+    ASSERT_EQ(tight.memory_bytes(), 0);
+}
+
+TEST(TraceDaemon, SocketRoundTripWithPipelining)
+{
+    auto path = "/tmp/trace_daemon_test." + std::to_string(::getpid()) + ".sock";
+    cells::TraceServer server(path);
+    std::thread serving([&]
+                        { server.run(); });
+
+    auto grid = lib::random_grid(30, 20, 0.15, 4);
+    auto text = lib::grid_to_lines(grid);
+    auto entries = cells::edge_entries(grid.width(), grid.height());
+    std::vector<std::uint64_t> expected;
+    for (const auto &entry : entries)
+    {
+        expected.push_back(cells::trace_grid(grid, entry.location, entry.direction));
+    }
+
+    {
+        cells::TraceClient client(path);
+        auto handle = client.load(text);
+        ASSERT_EQ(client.trace(handle, entries), expected);
+
+        // Many requests in flight before the first answer is read
+        std::vector<std::uint32_t> tags;
+        for (const auto &entry : entries)
+        {
+            tags.push_back(client.send_trace(handle, std::span(&entry, 1)));
+        }
+        for (std::size_t i = 0; i < entries.size(); ++i)
+        {
+            ASSERT_EQ(client.receive_trace(tags[i]), std::vector<std::uint64_t>{expected[i]});
+        }
+
+        // A second connection sees the same resident grid
+        cells::TraceClient other(path);
+        ASSERT_EQ(other.trace(handle, std::span(entries).first(3)), std::vector<std::uint64_t>(expected.begin(), expected.begin() + 3));
+
+        client.unload(handle);
+        ASSERT_THROW(other.trace(handle, entries), std::runtime_error);
+        ASSERT_THROW(client.unload(handle), std::runtime_error);
+    }
+
+    server.stop();
+    serving.join();
+    ASSERT_EQ(server.service().grid_count(), 0);
+    ASSERT_EQ(server.service().memory_bytes(), 0);
+}
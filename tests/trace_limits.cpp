@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <vector>
+#include "lib.h"
+
+TEST(TraceLimits, UnlimitedMatchesTraceGrid)
+{
+    auto grid = lib::lines_to_grid(std::string(lib::sample_data()));
+    auto result = cells::trace_grid(grid, {0, 0}, cells::Direction::Right, cells::TraceLimits{});
+    ASSERT_TRUE(result.complete);
+    ASSERT_EQ(result.energized, 46);
+    ASSERT_GT(result.steps, result.energized);
+}
+
+TEST(TraceLimits, CancelledAndExpiredTracesArePartial)
+{
+    auto grid = lib::random_grid(60, 60, 0.1, 1);
+    auto full = cells::trace_grid(grid, {0, 2}, cells::Direction::Right);
+
+    cells::CancellationToken token;
+    token.cancel();
+    cells::TraceLimits cancelled;
+    cancelled.cancel = &token;
+    cancelled.check_interval = 10;
+    auto partial = cells::trace_grid(grid, {0, 2}, cells::Direction::Right, cancelled);
+    ASSERT_FALSE(partial.complete);
+    ASSERT_EQ(partial.steps, 10);
+    ASSERT_LT(partial.energized, full);
+
+    cells::TraceLimits expired;
+    expired.deadline = std::chrono::steady_clock::now() - std::chrono::seconds(1);
+    expired.check_interval = 1;
+    partial = cells::trace_grid(grid, {0, 2}, cells::Direction::Right, expired);
+    ASSERT_FALSE(partial.complete);
+    ASSERT_EQ(partial.steps, 1);
+    ASSERT_EQ(partial.energized, 1);
+
+    cells::TraceLimits generous;
+    generous.deadline = std::chrono::steady_clock::now() + std::chrono::hours(1);
+    auto finished = cells::trace_grid(grid, {0, 2}, cells::Direction::Right, generous);
+    ASSERT_TRUE(finished.complete);
+    ASSERT_EQ(finished.energized, full);
+}
+
+TEST(TraceLimits, ProgressReportsGrowingCounts)
+{
+    auto grid = lib::random_grid(60, 60, 0.1, 1);
+    ASSERT_GT(cells::trace_grid(grid, {0, 2}, cells::Direction::Right, cells::TraceLimits{}).steps, 150);
+    std::vector<std::size_t> steps;
+    std::size_t last_energized = 0;
+    cells::CancellationToken token;
+    cells::TraceLimits limits;
+    limits.cancel = &token;
+    limits.check_interval = 50;
+    limits.progress = [&](std::size_t taken, std::size_t energized)
+    {
+        ASSERT_GE(energized, last_energized);
+        last_energized = energized;
+        steps.push_back(taken);
+        // A UI asking to stop from its progress callback
+        if (steps.size() == 3)
+        {
+            token.cancel();
+        }
+    };
+    auto result = cells::trace_grid(grid, {0, 2}, cells::Direction::Right, limits);
+    ASSERT_FALSE(result.complete);
+    ASSERT_EQ(steps, (std::vector<std::size_t>{50, 100, 150}));
+    ASSERT_EQ(result.steps, 150);
+}
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include <map>
+#include <numeric>
+#include <queue>
+#include <tuple>
+#include "lib.h"
+#include "trace_timeline.h"
+
+TEST(TraceTimeline, SampleSteps)
+{
+    auto grid = lib::lines_to_grid(std::string(lib::sample_data()));
+    auto timeline = cells::trace_timeline(grid, {0, 0}, cells::Direction::Right);
+    ASSERT_EQ(timeline.energized, 46);
+    // (0,0) then (1,0), whose splitter sends beams up off the grid and down column 1
+    ASSERT_GE(timeline.new_cells.size(), 3);
+    ASSERT_EQ(timeline.new_cells[0], 1);
+    ASSERT_EQ(timeline.new_cells[1], 1);
+    ASSERT_EQ(timeline.new_cells[2], 1);
+    ASSERT_NE(timeline.new_cells.back(), 0);
+
+    // An empty row is one new cell per step until the beam leaves
+    auto empty = lib::random_grid(7, 3, 0.0, 1);
+    ASSERT_EQ(cells::trace_timeline(empty, {0, 1}, cells::Direction::Right).new_cells, std::vector<std::uint32_t>(7, 1));
+    ASSERT_TRUE(cells::trace_timeline(empty, {-1, 0}, cells::Direction::Right).new_cells.empty());
+}
+
+TEST(TraceTimeline, TotalsMatchTraceGrid)
+{
+    for (unsigned seed = 1; seed < 4; ++seed)
+    {
+        auto grid = lib::random_grid(50, 40, 0.1 * seed, seed);
+        for (cells::Coord y = 0; y < grid.height(); y += 3)
+        {
+            auto timeline = cells::trace_timeline(grid, {0, y}, cells::Direction::Right);
+            ASSERT_EQ(timeline.energized, cells::trace_grid(grid, {0, y}, cells::Direction::Right));
+            ASSERT_EQ(std::accumulate(timeline.new_cells.begin(), timeline.new_cells.end(), std::size_t(0)), timeline.energized);
+        }
+    }
+}
+
+/// Shortest beam distance to every cell by plain BFS over (x, y, direction)
+/// states, then cells counted per distance
+static std::vector<std::uint32_t> steps_by_bfs(const cells::Grid &grid, cells::XY entry, cells::Direction direction)
+{
+    using State = std::tuple<cells::Coord, cells::Coord, cells::Direction>;
+    std::map<State, std::size_t> distance;
+    std::map<cells::XY, std::size_t> first;
+    std::queue<State> queue;
+    auto reach = [&](cells::Coord x, cells::Coord y, cells::Direction d, std::size_t step)
+    {
+        if (grid.at(x, y) && distance.emplace(State{x, y, d}, step).second)
+        {
+            queue.push({x, y, d});
+            first.emplace(cells::XY{x, y}, step);
+        }
+    };
+    reach(std::get<0>(entry), std::get<1>(entry), direction, 0);
+    while (!queue.empty())
+    {
+        auto [x, y, d] = queue.front();
+        queue.pop();
+        for (auto next : cells::next_directions(*grid.at(x, y), d))
+        {
+            auto [dx, dy] = cells::delta(next);
+            reach(x + dx, y + dy, next, distance[{x, y, d}] + 1);
+        }
+    }
+    std::vector<std::uint32_t> counts;
+    for (const auto &[cell, step] : first)
+    {
+        counts.resize(std::max(counts.size(), step + 1), 0);
+        counts[step]++;
+    }
+    return counts;
+}
+
+TEST(TraceTimeline, StepsMatchIndependentBfs)
+{
+    auto sample = lib::lines_to_grid(std::string(lib::sample_data()));
+    ASSERT_EQ(cells::trace_timeline(sample, {0, 0}, cells::Direction::Right).new_cells, steps_by_bfs(sample, {0, 0}, cells::Direction::Right));
+    for (unsigned seed = 1; seed < 4; ++seed)
+    {
+        auto grid = lib::random_grid(12, 9, 0.15 * seed, seed);
+        for (cells::Coord y = 0; y < grid.height(); ++y)
+        {
+            ASSERT_EQ(cells::trace_timeline(grid, {0, y}, cells::Direction::Right).new_cells, steps_by_bfs(grid, {0, y}, cells::Direction::Right));
+        }
+    }
+}
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <limits>
+#include <thread>
+#include <vector>
+#include "simulation.h"
+#include "transition_metrics.h"
+
+using namespace state_machine;
+
+// The default observer takes no space in the behavior
+static_assert(sizeof(PolledButtonBehavior) == 3 * sizeof(void *));
+
+TEST(TransitionMetrics, CountsTransitionsAndDwellTimes)
+{
+    VirtualClock clock;
+    SimIO io(clock);
+    SimTimer timer(clock);
+    TransitionMetrics metrics;
+    BasicPolledButtonBehavior<MetricsObserver> behavior(io, timer, MetricsObserver(metrics, [&clock]
+                                                                                    { return clock.now(); }));
+
+    // Idle for two seconds, then blink for 3.5 seconds
+    clock.advance_to(2.0);
+    io.button_pressed_value = true;
+    behavior.do_work();
+    for (double t = 3.0; t <= 5.0; t += 1.0)
+    {
+        clock.advance_to(t);
+        behavior.do_work();
+    }
+    clock.advance_to(5.5);
+    io.button_pressed_value = false;
+    behavior.do_work();
+
+    using S = ButtonStates;
+    ASSERT_EQ(metrics.transition_count(S::NotPressed, S::BlinkOn), 1);
+    ASSERT_EQ(metrics.transition_count(S::BlinkOn, S::BlinkOff), 2);
+    ASSERT_EQ(metrics.transition_count(S::BlinkOff, S::BlinkOn), 1);
+    ASSERT_EQ(metrics.transition_count(S::BlinkOff, S::ReleasedButton), 1);
+    ASSERT_EQ(metrics.transition_count(S::ReleasedButton, S::NotPressed), 1);
+    ASSERT_EQ(metrics.transition_count(S::BlinkOn, S::ReleasedButton), 0);
+
+    ASSERT_EQ(metrics.dwell_count(S::NotPressed), 1);
+    ASSERT_DOUBLE_EQ(metrics.total_dwell_seconds(S::NotPressed), 2.0);
+    ASSERT_EQ(metrics.dwell_count(S::BlinkOn), 2);
+    ASSERT_DOUBLE_EQ(metrics.total_dwell_seconds(S::BlinkOn), 2.0);
+    ASSERT_EQ(metrics.dwell_count(S::BlinkOff), 2);
+    ASSERT_DOUBLE_EQ(metrics.total_dwell_seconds(S::BlinkOff), 1.5);
+
+    // One full second off and the half second before release
+    auto histogram = metrics.dwell_histogram(S::BlinkOff);
+    ASSERT_EQ(histogram[TransitionMetrics::bucket_for(1.0)], 1);
+    ASSERT_EQ(histogram[TransitionMetrics::bucket_for(0.5)], 1);
+}
+
+TEST(TransitionMetrics, ThreadsRecordConcurrently)
+{
+    TransitionMetrics metrics;
+    const int per_thread = 10000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t)
+    {
+        threads.emplace_back([&metrics]
+                             {
+            for (int i = 0; i < per_thread; ++i)
+            {
+                metrics.record(ButtonStates::BlinkOn, ButtonStates::BlinkOff, 1.0);
+            } });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    ASSERT_EQ(metrics.transition_count(ButtonStates::BlinkOn, ButtonStates::BlinkOff), 8 * per_thread);
+    ASSERT_EQ(metrics.dwell_count(ButtonStates::BlinkOn), 8 * per_thread);
+}
+
+TEST(TransitionMetrics, HugeAndInfiniteDwellsSaturate)
+{
+    const auto last = TransitionMetrics::histogram_buckets - 1;
+    ASSERT_EQ(TransitionMetrics::bucket_for(std::numeric_limits<double>::infinity()), last);
+    ASSERT_EQ(TransitionMetrics::bucket_for(1e300), last);
+    ASSERT_EQ(TransitionMetrics::bucket_for(std::ldexp(1.0, 38) * 1e-6), last);
+    ASSERT_EQ(TransitionMetrics::bucket_for(std::ldexp(1.0, 37) * 1e-6), last - 1);
+    ASSERT_EQ(TransitionMetrics::bucket_for(-std::numeric_limits<double>::infinity()), 0);
+
+    TransitionMetrics metrics;
+    metrics.record(ButtonStates::BlinkOn, ButtonStates::BlinkOff, std::numeric_limits<double>::infinity());
+    metrics.record(ButtonStates::BlinkOn, ButtonStates::BlinkOff, 1e300);
+    ASSERT_EQ(metrics.dwell_count(ButtonStates::BlinkOn), 2);
+    ASSERT_EQ(metrics.dwell_histogram(ButtonStates::BlinkOn)[last], 2);
+    // Capped at UINT64_MAX nanoseconds rather than wrapped
+    ASSERT_DOUBLE_EQ(metrics.total_dwell_seconds(ButtonStates::BlinkOn), static_cast<double>(UINT64_MAX) * 1e-9);
+}